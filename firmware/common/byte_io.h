@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ct {
+
+// Little-endian field access for wire and flash layouts. Structs are never
+// memcpy'd directly so the layouts stay independent of compiler padding.
+
+inline void put_u16(uint8_t* p, uint16_t v) {
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+inline void put_u32(uint8_t* p, uint32_t v) {
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+  p[2] = static_cast<uint8_t>(v >> 16);
+  p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+inline uint16_t get_u16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t get_u32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint32_t align_down(uint32_t v, uint32_t align) {
+  return v - (v % align);
+}
+
+inline uint32_t align_up(uint32_t v, uint32_t align) {
+  return align_down(v + align - 1, align);
+}
+
+// True when every byte still reads as erased NOR flash (0xFF): the end of
+// an append-only log, or a record whose program never started.
+inline bool all_erased(const uint8_t* p, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (p[i] != 0xFF) return false;
+  }
+  return true;
+}
+
+}  // namespace ct
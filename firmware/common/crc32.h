@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ct {
+
+// CRC-32 (IEEE 802.3, reflected, as used by zlib). Pass the previous return
+// value as |crc| to continue a running checksum; start from 0.
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len);
+
+inline uint32_t crc32(const void* data, size_t len) {
+  return crc32_update(0, data, len);
+}
+
+}  // namespace ct
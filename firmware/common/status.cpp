@@ -0,0 +1,29 @@
+#include "common/status.h"
+
+namespace ct {
+
+const char* status_name(Status s) {
+  switch (s) {
+    case Status::kOk:
+      return "ok";
+    case Status::kIoError:
+      return "io_error";
+    case Status::kOutOfRange:
+      return "out_of_range";
+    case Status::kBadArgument:
+      return "bad_argument";
+    case Status::kBadState:
+      return "bad_state";
+    case Status::kCrcMismatch:
+      return "crc_mismatch";
+    case Status::kCorrupt:
+      return "corrupt";
+    case Status::kNoSpace:
+      return "no_space";
+    case Status::kDisconnected:
+      return "disconnected";
+  }
+  return "unknown";
+}
+
+}  // namespace ct
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ct {
+
+// Result code shared by all device-side modules. Firmware code never throws;
+// every fallible call returns one of these.
+enum class Status : uint8_t {
+  kOk = 0,
+  kIoError,
+  kOutOfRange,
+  kBadArgument,
+  kBadState,
+  kCrcMismatch,
+  kCorrupt,
+  kNoSpace,
+  kDisconnected,
+};
+
+const char* status_name(Status s);
+
+inline bool is_ok(Status s) { return s == Status::kOk; }
+
+}  // namespace ct
+
+// Propagates a non-OK Status to the caller.
+#define CT_RETURN_IF_ERROR(expr)            \
+  do {                                      \
+    ::ct::Status ct_status_ = (expr);       \
+    if (ct_status_ != ::ct::Status::kOk) {  \
+      return ct_status_;                    \
+    }                                       \
+  } while (0)
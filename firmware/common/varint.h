@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ct {
+
+constexpr size_t kMaxVarint32Size = 5;
+
+// LEB128 unsigned varint. Returns the number of bytes written.
+inline size_t put_varint(uint8_t* out, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = static_cast<uint8_t>(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(v);
+  return n;
+}
+
+// Decodes a varint from [p, p + len). Returns the bytes consumed, 0 if the
+// input ends mid-varint, or -1 if it is longer than kMaxVarint32Size.
+inline int get_varint(const uint8_t* p, size_t len, uint32_t* v) {
+  uint32_t result = 0;
+  for (size_t i = 0; i < kMaxVarint32Size; ++i) {
+    if (i == len) return 0;
+    result |= static_cast<uint32_t>(p[i] & 0x7F) << (7 * i);
+    if ((p[i] & 0x80) == 0) {
+      *v = result;
+      return static_cast<int>(i + 1);
+    }
+  }
+  return -1;
+}
+
+// Two's-complement wraparound, so deltas between any two int32 values
+// round-trip without signed overflow.
+inline int32_t wrapping_sub(int32_t a, int32_t b) {
+  return static_cast<int32_t>(static_cast<uint32_t>(a) -
+                              static_cast<uint32_t>(b));
+}
+
+inline int32_t wrapping_add(int32_t a, int32_t b) {
+  return static_cast<int32_t>(static_cast<uint32_t>(a) +
+                              static_cast<uint32_t>(b));
+}
+
+inline uint32_t zigzag_encode(int32_t v) {
+  return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+inline int32_t zigzag_decode(uint32_t v) {
+  return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+}  // namespace ct
@@ -0,0 +1,36 @@
+#include "hal/flash.h"
+
+namespace ct {
+
+bool Partition::valid() const {
+  if (flash_ == nullptr || size_ == 0) return false;
+  const uint32_t sector = flash_->sector_size();
+  return offset_ % sector == 0 && size_ % sector == 0 &&
+         offset_ <= flash_->size() && size_ <= flash_->size() - offset_;
+}
+
+Status Partition::read(uint32_t addr, void* dst, size_t len) const {
+  if (!in_range(addr, len)) return Status::kOutOfRange;
+  return flash_->read(offset_ + addr, dst, len);
+}
+
+Status Partition::program(uint32_t addr, const void* src, size_t len) const {
+  if (!in_range(addr, len)) return Status::kOutOfRange;
+  return flash_->program(offset_ + addr, src, len);
+}
+
+Status Partition::erase_sector(uint32_t addr) const {
+  if (!in_range(addr, 1) || addr % sector_size() != 0) {
+    return Status::kOutOfRange;
+  }
+  return flash_->erase_sector(offset_ + addr);
+}
+
+Status Partition::erase_all() const {
+  for (uint32_t addr = 0; addr < size_; addr += sector_size()) {
+    CT_RETURN_IF_ERROR(flash_->erase_sector(offset_ + addr));
+  }
+  return Status::kOk;
+}
+
+}  // namespace ct
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+
+namespace ct {
+
+// NOR flash driver interface. Erased bytes read as 0xFF and program() can only
+// clear bits, so every sector must be erased before it is written. Programming
+// a byte with the value it already holds is always allowed, which is what
+// makes replaying a torn write safe.
+class Flash {
+ public:
+  virtual ~Flash() = default;
+
+  virtual uint32_t size() const = 0;
+  virtual uint32_t sector_size() const = 0;
+
+  virtual Status read(uint32_t addr, void* dst, size_t len) = 0;
+  virtual Status program(uint32_t addr, const void* src, size_t len) = 0;
+  virtual Status erase_sector(uint32_t addr) = 0;
+};
+
+// A sector-aligned window onto a Flash device. Addresses passed to a Partition
+// are relative to its start and bounds-checked.
+class Partition {
+ public:
+  Partition() = default;
+  Partition(Flash* flash, uint32_t offset, uint32_t size)
+      : flash_(flash), offset_(offset), size_(size) {}
+
+  bool valid() const;
+  uint32_t offset() const { return offset_; }
+  uint32_t size() const { return size_; }
+  uint32_t sector_size() const { return flash_->sector_size(); }
+  Flash* flash() const { return flash_; }
+
+  Status read(uint32_t addr, void* dst, size_t len) const;
+  Status program(uint32_t addr, const void* src, size_t len) const;
+  Status erase_sector(uint32_t addr) const;
+  Status erase_all() const;
+
+ private:
+  bool in_range(uint32_t addr, size_t len) const {
+    return addr <= size_ && len <= size_ - addr;
+  }
+
+  Flash* flash_ = nullptr;
+  uint32_t offset_ = 0;
+  uint32_t size_ = 0;
+};
+
+}  // namespace ct
@@ -0,0 +1,228 @@
+#include "ota/boot_manager.h"
+
+#include "common/byte_io.h"
+#include "common/crc32.h"
+
+namespace ct {
+namespace ota {
+namespace {
+
+constexpr uint32_t kBootMagic = 0x31425443;  // "CTB1"
+constexpr uint32_t kRecordSize = 48;
+constexpr uint32_t kSlotFieldSize = 16;
+
+}  // namespace
+
+// Record layout:
+//   [u32 magic][u32 seq][u8 confirmed][u8 pending][u8 attempts][u8 0xFF]
+//   2 x [u8 state][3 x 0xFF][u32 size][u32 crc32][u32 version]
+//   [u32 crc]
+void BootManager::encode_record(uint32_t seq, const Record& r, uint8_t* out) {
+  for (uint32_t i = 0; i < kRecordSize; ++i) out[i] = 0xFF;
+  put_u32(out, kBootMagic);
+  put_u32(out + 4, seq);
+  out[8] = r.confirmed;
+  out[9] = r.pending;
+  out[10] = r.attempts;
+  for (uint8_t i = 0; i < kSlotCount; ++i) {
+    uint8_t* p = out + 12 + i * kSlotFieldSize;
+    p[0] = static_cast<uint8_t>(r.slots[i].state);
+    put_u32(p + 4, r.slots[i].size);
+    put_u32(p + 8, r.slots[i].crc32);
+    put_u32(p + 12, r.slots[i].version);
+  }
+  put_u32(out + kRecordSize - 4, crc32(out, kRecordSize - 4));
+}
+
+bool BootManager::decode_record(const uint8_t* in, uint32_t* seq,
+                                Record* r) {
+  if (get_u32(in) != kBootMagic ||
+      get_u32(in + kRecordSize - 4) != crc32(in, kRecordSize - 4)) {
+    return false;
+  }
+  const uint8_t pending = in[9];
+  if (in[8] >= kSlotCount || (pending >= kSlotCount && pending != kNoSlot)) {
+    return false;
+  }
+  *seq = get_u32(in + 4);
+  r->confirmed = in[8];
+  r->pending = pending;
+  r->attempts = in[10];
+  for (uint8_t i = 0; i < kSlotCount; ++i) {
+    const uint8_t* p = in + 12 + i * kSlotFieldSize;
+    if (p[0] > static_cast<uint8_t>(SlotState::kBad)) return false;
+    r->slots[i].state = static_cast<SlotState>(p[0]);
+    r->slots[i].size = get_u32(p + 4);
+    r->slots[i].crc32 = get_u32(p + 8);
+    r->slots[i].version = get_u32(p + 12);
+  }
+  return true;
+}
+
+BootManager::BootManager(Partition state, const BootPolicy& policy)
+    : state_(state), policy_(policy) {}
+
+Status BootManager::mount() {
+  mounted_ = false;
+  if (!state_.valid()) return Status::kBadState;
+  const uint32_t sector_size = state_.sector_size();
+  const uint32_t sectors = state_.size() / sector_size;
+  if (sectors < 2 || sector_size < kRecordSize) return Status::kBadArgument;
+
+  bool found = false;
+  for (uint32_t s = 0; s < sectors; ++s) {
+    // Records are appended in order; a torn one is skipped but still
+    // occupies its place, so the next record goes after it.
+    uint32_t used = 0;
+    uint32_t best_here = 0;
+    bool found_here = false;
+    Record best_rec;
+    while (used + kRecordSize <= sector_size) {
+      uint8_t buf[kRecordSize];
+      CT_RETURN_IF_ERROR(
+          state_.read(s * sector_size + used, buf, sizeof(buf)));
+      if (all_erased(buf, sizeof(buf))) break;
+      used += kRecordSize;
+      uint32_t seq = 0;
+      Record r;
+      if (!decode_record(buf, &seq, &r)) continue;
+      if (!found_here || seq > best_here) {
+        best_here = seq;
+        best_rec = r;
+        found_here = true;
+      }
+    }
+    if (found_here && (!found || best_here > seq_)) {
+      seq_ = best_here;
+      rec_ = best_rec;
+      sector_ = s;
+      next_ = used;
+      found = true;
+    }
+  }
+  if (!found) return Status::kCorrupt;
+  mounted_ = true;
+  return Status::kOk;
+}
+
+Status BootManager::format(uint8_t slot, uint32_t size, uint32_t crc32,
+                           uint32_t version) {
+  if (slot >= kSlotCount) return Status::kBadArgument;
+  if (!state_.valid()) return Status::kBadState;
+  if (state_.size() / state_.sector_size() < 2) return Status::kBadArgument;
+  mounted_ = false;
+  CT_RETURN_IF_ERROR(state_.erase_all());
+  seq_ = 0;
+  sector_ = 0;
+  next_ = 0;
+  mounted_ = true;
+  Record next;
+  next.confirmed = slot;
+  next.slots[slot] = {SlotState::kGood, size, crc32, version};
+  return commit(next);
+}
+
+Status BootManager::commit(const Record& next) {
+  if (!mounted_) return Status::kBadState;
+  const uint32_t sector_size = state_.sector_size();
+  if (next_ + kRecordSize > sector_size) {
+    // The full sector keeps the newest record until the first record of
+    // the freshly erased one is intact.
+    const uint32_t sectors = state_.size() / sector_size;
+    const uint32_t target = (sector_ + 1) % sectors;
+    CT_RETURN_IF_ERROR(state_.erase_sector(target * sector_size));
+    sector_ = target;
+    next_ = 0;
+  }
+  uint8_t buf[kRecordSize];
+  encode_record(seq_ + 1, next, buf);
+  const uint32_t addr = sector_ * sector_size + next_;
+  next_ += kRecordSize;
+  CT_RETURN_IF_ERROR(state_.program(addr, buf, sizeof(buf)));
+  ++seq_;
+  rec_ = next;
+  return Status::kOk;
+}
+
+Status BootManager::select_boot(uint8_t* slot) {
+  if (!mounted_) return Status::kBadState;
+  if (rec_.pending == kNoSlot) {
+    *slot = rec_.confirmed;
+    return Status::kOk;
+  }
+  Record next = rec_;
+  if (rec_.attempts < policy_.max_attempts) {
+    // Counted before the jump: an image that dies before confirming
+    // itself has still used the attempt.
+    ++next.attempts;
+    CT_RETURN_IF_ERROR(commit(next));
+    *slot = rec_.pending;
+    return Status::kOk;
+  }
+  next.slots[rec_.pending].state = SlotState::kBad;
+  next.pending = kNoSlot;
+  next.attempts = 0;
+  CT_RETURN_IF_ERROR(commit(next));
+  *slot = rec_.confirmed;
+  return Status::kOk;
+}
+
+Status BootManager::confirm() {
+  if (!mounted_ || rec_.pending == kNoSlot || rec_.attempts == 0) {
+    return Status::kBadState;
+  }
+  Record next = rec_;
+  next.slots[rec_.pending].state = SlotState::kGood;
+  next.confirmed = rec_.pending;
+  next.pending = kNoSlot;
+  next.attempts = 0;
+  return commit(next);
+}
+
+Status BootManager::reject() {
+  if (!mounted_ || rec_.pending == kNoSlot) return Status::kBadState;
+  Record next = rec_;
+  next.slots[rec_.pending].state = SlotState::kBad;
+  next.pending = kNoSlot;
+  next.attempts = 0;
+  return commit(next);
+}
+
+bool BootManager::installed(uint32_t size, uint32_t crc32) const {
+  const SlotInfo& s = rec_.slots[rec_.confirmed];
+  return mounted_ && s.state == SlotState::kGood && s.size == size &&
+         s.crc32 == crc32;
+}
+
+Status BootManager::begin_update(uint8_t* slot) {
+  if (!mounted_) return Status::kBadState;
+  const uint8_t target = rec_.confirmed ^ 1;
+  if (rec_.slots[target].state != SlotState::kEmpty ||
+      rec_.pending == target) {
+    Record next = rec_;
+    next.slots[target] = SlotInfo();
+    if (next.pending == target) {
+      next.pending = kNoSlot;
+      next.attempts = 0;
+    }
+    CT_RETURN_IF_ERROR(commit(next));
+  }
+  *slot = target;
+  return Status::kOk;
+}
+
+Status BootManager::stage(uint8_t slot, uint32_t size, uint32_t crc32,
+                          uint32_t version) {
+  if (!mounted_) return Status::kBadState;
+  if (slot >= kSlotCount || slot == rec_.confirmed) {
+    return Status::kBadArgument;
+  }
+  Record next = rec_;
+  next.slots[slot] = {SlotState::kPending, size, crc32, version};
+  next.pending = slot;
+  next.attempts = 0;
+  return commit(next);
+}
+
+}  // namespace ota
+}  // namespace ct
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+#include "hal/flash.h"
+
+namespace ct {
+namespace ota {
+
+enum class SlotState : uint8_t {
+  kEmpty = 0,    // nothing bootable, or an update is being written
+  kPending = 1,  // verified image waiting for its trial boots
+  kGood = 2,     // passed a health check
+  kBad = 3,      // failed its trial; never booted again
+};
+
+struct SlotInfo {
+  SlotState state = SlotState::kEmpty;
+  uint32_t size = 0;
+  uint32_t crc32 = 0;
+  uint32_t version = 0;
+};
+
+struct BootPolicy {
+  // Boots a pending image gets to confirm itself before the bootloader
+  // falls back to the last good one.
+  uint8_t max_attempts = 3;
+};
+
+// A/B slot selection with rollback, shared by the bootloader and the
+// application.
+//
+// One slot holds the confirmed image. An update is written into the other
+// slot, verified while it streams in (OtaReceiver), then staged as pending.
+// Each boot of a pending image is counted before control passes to it; the
+// image promotes itself with confirm() once its health check passes. If it
+// crashes, hangs or rejects itself before that, the bootloader returns to the
+// confirmed slot after max_attempts boots and marks the new image bad.
+//
+// All state is one small record, appended to the current sector of |state|
+// (two or more sectors) with a sequence number and CRC; when the sector is
+// full the next one is erased and the record goes there. The newest intact
+// record wins at mount, so a power cut at any write leaves either the old or
+// the new decision, never a mix.
+class BootManager {
+ public:
+  static constexpr uint8_t kSlotCount = 2;
+  static constexpr uint8_t kNoSlot = 0xFF;
+
+  explicit BootManager(Partition state,
+                       const BootPolicy& policy = BootPolicy());
+
+  // Loads the newest intact record. kCorrupt when there is none yet.
+  Status mount();
+
+  // Starts from scratch: |slot| holds a known-good (factory) image.
+  Status format(uint8_t slot, uint32_t size, uint32_t crc32,
+                uint32_t version);
+
+  // Bootloader entry: chooses the slot to run. Booting a pending image
+  // spends one of its attempts first.
+  Status select_boot(uint8_t* slot);
+
+  // The running pending image passed its health check.
+  Status confirm();
+
+  // The running pending image failed its health check: fall back on the
+  // next boot without spending the remaining attempts.
+  Status reject();
+
+  // True when the confirmed slot already holds the image with |size| and
+  // |crc32|. Check an offer against it before begin_update(), which would
+  // blank the other slot and with it the rollback image.
+  bool installed(uint32_t size, uint32_t crc32) const;
+
+  // Returns the slot an update may be written into. Marks it empty first,
+  // so a slot that is half rewritten can never be chosen to boot.
+  Status begin_update(uint8_t* slot);
+
+  // Queues the verified image in |slot| for trial on the next boot.
+  Status stage(uint8_t slot, uint32_t size, uint32_t crc32, uint32_t version);
+
+  uint8_t confirmed_slot() const { return rec_.confirmed; }
+  uint8_t pending_slot() const { return rec_.pending; }
+  uint8_t attempts() const { return rec_.attempts; }
+  const SlotInfo& slot(uint8_t i) const { return rec_.slots[i]; }
+  uint32_t sequence() const { return seq_; }
+
+ private:
+  struct Record {
+    uint8_t confirmed = 0;
+    uint8_t pending = kNoSlot;
+    uint8_t attempts = 0;  // boots of the pending image so far
+    SlotInfo slots[kSlotCount];
+  };
+
+  static void encode_record(uint32_t seq, const Record& r, uint8_t* out);
+  static bool decode_record(const uint8_t* in, uint32_t* seq, Record* r);
+
+  // Persists |next| as the newest record; only then does it take effect.
+  Status commit(const Record& next);
+
+  Partition state_;
+  BootPolicy policy_;
+  bool mounted_ = false;
+  uint32_t seq_ = 0;
+  uint32_t sector_ = 0;    // sector holding the newest record
+  uint32_t next_ = 0;      // append offset within that sector
+  Record rec_;
+};
+
+}  // namespace ota
+}  // namespace ct
@@ -0,0 +1,98 @@
+#include "ota/delta_applier.h"
+
+namespace ct {
+namespace ota {
+
+void DeltaApplier::restart(uint32_t op_start, uint32_t out_offset,
+                           uint32_t out_crc) {
+  pos_ = op_start;
+  op_start_ = op_start;
+  op_out_ = out_offset;
+  op_crc_ = out_crc;
+  add_left_ = 0;
+  hdr_len_ = 0;
+  out_->seek(out_offset, out_crc);
+}
+
+void DeltaApplier::end_op() {
+  op_start_ = pos_;
+  op_out_ = out_->offset();
+  op_crc_ = out_->crc();
+}
+
+Status DeltaApplier::feed(uint32_t pos, const uint8_t* data, size_t len) {
+  if (pos > pos_) return Status::kOutOfRange;
+  if (pos_ - pos >= len) return Status::kOk;
+  const size_t skip = pos_ - pos;
+  data += skip;
+  len -= skip;
+
+  while (len > 0) {
+    if (add_left_ > 0) {
+      const uint32_t n =
+          len < add_left_ ? static_cast<uint32_t>(len) : add_left_;
+      CT_RETURN_IF_ERROR(out_->write(data, n));
+      data += n;
+      len -= n;
+      pos_ += n;
+      add_left_ -= n;
+      if (add_left_ == 0) end_op();
+      continue;
+    }
+    hdr_[hdr_len_++] = *data++;
+    --len;
+    ++pos_;
+    bool complete = false;
+    CT_RETURN_IF_ERROR(decode_header(&complete));
+    if (!complete && hdr_len_ == sizeof(hdr_)) return Status::kCorrupt;
+  }
+  return Status::kOk;
+}
+
+Status DeltaApplier::decode_header(bool* complete) {
+  *complete = false;
+  const uint8_t* p = hdr_ + 1;
+  const size_t avail = hdr_len_ - 1;
+  uint32_t a = 0;
+  const int na = get_varint(p, avail, &a);
+  if (na < 0) return Status::kCorrupt;
+  if (na == 0) return Status::kOk;
+
+  switch (static_cast<delta::Op>(hdr_[0])) {
+    case delta::Op::kAdd:
+      if (a == 0) return Status::kCorrupt;
+      hdr_len_ = 0;
+      add_left_ = a;
+      *complete = true;
+      return Status::kOk;
+    case delta::Op::kCopy: {
+      uint32_t b = 0;
+      const int nb = get_varint(p + na, avail - na, &b);
+      if (nb < 0) return Status::kCorrupt;
+      if (nb == 0) return Status::kOk;
+      hdr_len_ = 0;
+      *complete = true;
+      CT_RETURN_IF_ERROR(copy_from_base(a, b));
+      end_op();
+      return Status::kOk;
+    }
+  }
+  return Status::kCorrupt;
+}
+
+Status DeltaApplier::copy_from_base(uint32_t src, uint32_t len) {
+  if (len == 0 || src > base_.size() || len > base_.size() - src) {
+    return Status::kCorrupt;
+  }
+  while (len > 0) {
+    const uint32_t n = len < sizeof(buf_) ? len : sizeof(buf_);
+    CT_RETURN_IF_ERROR(base_.read(src, buf_, n));
+    CT_RETURN_IF_ERROR(out_->write(buf_, n));
+    src += n;
+    len -= n;
+  }
+  return Status::kOk;
+}
+
+}  // namespace ota
+}  // namespace ct
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+#include "hal/flash.h"
+#include "ota/delta_format.h"
+#include "ota/slot_writer.h"
+
+namespace ct {
+namespace ota {
+
+// Streaming patch decoder. Add literals are written straight from the
+// caller's frame; Copy ops are pulled from the base slot through a fixed
+// buffer, so working memory is bounded by sizeof(DeltaApplier) whatever the
+// image or patch size.
+class DeltaApplier {
+ public:
+  static constexpr size_t kCopyBufferSize = 256;
+
+  DeltaApplier(Partition base, SlotWriter* out) : base_(base), out_(out) {}
+
+  // Restarts decoding at an op boundary: |op_start| patch bytes have been
+  // applied, producing the target up to |out_offset| with CRC-32 |out_crc|.
+  void restart(uint32_t op_start, uint32_t out_offset, uint32_t out_crc);
+
+  // Consumes patch bytes [pos, pos + len). Bytes already consumed (resent
+  // after a resume) are skipped; a gap is an error.
+  Status feed(uint32_t pos, const uint8_t* data, size_t len);
+
+  // Patch offset, target offset and target CRC at the start of the op being
+  // decoded. Together they are a complete resume point.
+  uint32_t op_start() const { return op_start_; }
+  uint32_t op_out() const { return op_out_; }
+  uint32_t op_crc() const { return op_crc_; }
+  bool at_op_boundary() const { return hdr_len_ == 0 && add_left_ == 0; }
+
+ private:
+  Status decode_header(bool* complete);
+  Status copy_from_base(uint32_t src, uint32_t len);
+  void end_op();
+
+  Partition base_;
+  SlotWriter* out_;
+  uint32_t pos_ = 0;
+  uint32_t op_start_ = 0;
+  uint32_t op_out_ = 0;
+  uint32_t op_crc_ = 0;
+  uint32_t add_left_ = 0;
+  uint8_t hdr_len_ = 0;
+  uint8_t hdr_[delta::kMaxOpHeaderSize];
+  uint8_t buf_[kCopyBufferSize];
+};
+
+}  // namespace ota
+}  // namespace ct
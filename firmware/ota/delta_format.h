@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/varint.h"
+
+namespace ct {
+namespace ota {
+namespace delta {
+
+// A delta patch is a bare sequence of ops that rebuilds the target image
+// front to back; sizes and CRCs of base and target travel in the OTA offer.
+//
+//   Copy [u8 0][varint base_offset][varint len]   len bytes from the base
+//   Add  [u8 1][varint len][len literal bytes]    len bytes from the patch
+//
+// Copy offsets are absolute so every op decodes on its own. That is what lets
+// the receiver checkpoint at any op boundary and resume there after a reboot.
+
+enum class Op : uint8_t {
+  kCopy = 0,
+  kAdd = 1,
+};
+
+constexpr size_t kMaxOpHeaderSize = 1 + 2 * kMaxVarint32Size;
+
+}  // namespace delta
+}  // namespace ota
+}  // namespace ct
@@ -0,0 +1,109 @@
+#include "ota/ota_protocol.h"
+
+#include <cstring>
+
+#include "common/byte_io.h"
+#include "common/crc32.h"
+
+namespace ct {
+namespace ota {
+
+uint16_t ImageInfo::chunk_len(uint32_t index) const {
+  const uint32_t start = index * chunk_size;
+  if (start >= size) return 0;
+  const uint32_t left = size - start;
+  return static_cast<uint16_t>(left < chunk_size ? left : chunk_size);
+}
+
+bool operator==(const ImageInfo& a, const ImageInfo& b) {
+  return a.kind == b.kind && a.size == b.size && a.crc32 == b.crc32 &&
+         a.version == b.version && a.chunk_size == b.chunk_size &&
+         a.target_size == b.target_size && a.target_crc32 == b.target_crc32 &&
+         a.base_size == b.base_size && a.base_crc32 == b.base_crc32;
+}
+
+size_t encode_offer(const ImageInfo& info, uint8_t* out) {
+  out[0] = static_cast<uint8_t>(FrameType::kOffer);
+  out[1] = static_cast<uint8_t>(info.kind);
+  put_u32(out + 2, info.size);
+  put_u32(out + 6, info.crc32);
+  put_u32(out + 10, info.version);
+  put_u16(out + 14, info.chunk_size);
+  put_u32(out + 16, info.target_size);
+  put_u32(out + 20, info.target_crc32);
+  put_u32(out + 24, info.base_size);
+  put_u32(out + 28, info.base_crc32);
+  put_u32(out + 32, crc32(out, 32));
+  return kOfferFrameSize;
+}
+
+size_t encode_chunk(uint32_t index, const uint8_t* data, uint16_t len,
+                    uint8_t* out) {
+  out[0] = static_cast<uint8_t>(FrameType::kChunk);
+  put_u32(out + 1, index);
+  put_u16(out + 5, len);
+  put_u32(out + 7, crc32(data, len));
+  std::memcpy(out + kChunkHeaderSize, data, len);
+  return kChunkHeaderSize + len;
+}
+
+size_t encode_finish(uint8_t* out) {
+  out[0] = static_cast<uint8_t>(FrameType::kFinish);
+  return 1;
+}
+
+size_t encode_ack(const Ack& ack, uint8_t* out) {
+  out[0] = static_cast<uint8_t>(ack.status);
+  put_u32(out + 1, ack.next_chunk);
+  return kAckFrameSize;
+}
+
+Status decode_offer(const uint8_t* frame, size_t len, ImageInfo* info) {
+  if (len != kOfferFrameSize ||
+      frame[0] != static_cast<uint8_t>(FrameType::kOffer) ||
+      get_u32(frame + 32) != crc32(frame, 32)) {
+    return Status::kCorrupt;
+  }
+  info->kind = static_cast<ImageKind>(frame[1]);
+  info->size = get_u32(frame + 2);
+  info->crc32 = get_u32(frame + 6);
+  info->version = get_u32(frame + 10);
+  info->chunk_size = get_u16(frame + 14);
+  info->target_size = get_u32(frame + 16);
+  info->target_crc32 = get_u32(frame + 20);
+  info->base_size = get_u32(frame + 24);
+  info->base_crc32 = get_u32(frame + 28);
+  return Status::kOk;
+}
+
+Status decode_chunk(const uint8_t* frame, size_t len, ChunkView* out) {
+  if (len < kChunkHeaderSize ||
+      frame[0] != static_cast<uint8_t>(FrameType::kChunk)) {
+    return Status::kCorrupt;
+  }
+  out->index = get_u32(frame + 1);
+  out->len = get_u16(frame + 5);
+  out->crc32 = get_u32(frame + 7);
+  out->data = frame + kChunkHeaderSize;
+  if (out->len > kMaxChunkSize || len != kChunkHeaderSize + out->len) {
+    return Status::kCorrupt;
+  }
+  return Status::kOk;
+}
+
+Status decode_finish(const uint8_t* frame, size_t len) {
+  if (len != 1 || frame[0] != static_cast<uint8_t>(FrameType::kFinish)) {
+    return Status::kCorrupt;
+  }
+  return Status::kOk;
+}
+
+Status decode_ack(const uint8_t* frame, size_t len, Ack* ack) {
+  if (len != kAckFrameSize) return Status::kCorrupt;
+  ack->status = static_cast<Status>(frame[0]);
+  ack->next_chunk = get_u32(frame + 1);
+  return Status::kOk;
+}
+
+}  // namespace ota
+}  // namespace ct
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+
+namespace ct {
+namespace ota {
+
+// Wire format of the OTA session. Every request frame is answered with an Ack.
+//
+//   Offer  [u8 type=1][u8 kind][u32 size][u32 crc32][u32 version]
+//          [u16 chunk_size][u32 target_size][u32 target_crc32]
+//          [u32 base_size][u32 base_crc32][u32 crc32(preceding bytes)]
+//   Chunk  [u8 type=2][u32 index][u16 len][u32 crc32(payload)][payload]
+//   Finish [u8 type=3]
+//   Ack    [u8 status][u32 next_chunk]
+//
+// All integers are little-endian. A chunk is the unit of retransmission; only
+// the final chunk of a payload may be short. The payload is either the image
+// itself (kFull) or a patch against the running image (kDelta, see
+// delta_format.h); target_* always describe the image that ends up in flash.
+
+constexpr uint16_t kMaxChunkSize = 1024;
+constexpr size_t kOfferFrameSize = 36;
+constexpr size_t kChunkHeaderSize = 11;
+constexpr size_t kMaxFrameSize = kChunkHeaderSize + kMaxChunkSize;
+constexpr size_t kAckFrameSize = 5;
+
+enum class FrameType : uint8_t {
+  kOffer = 1,
+  kChunk = 2,
+  kFinish = 3,
+};
+
+enum class ImageKind : uint8_t {
+  kFull = 0,
+  kDelta = 1,
+};
+
+struct ImageInfo {
+  ImageKind kind = ImageKind::kFull;
+  uint32_t size = 0;  // payload bytes on the wire
+  uint32_t crc32 = 0;
+  uint32_t version = 0;
+  uint16_t chunk_size = 0;
+  uint32_t target_size = 0;
+  uint32_t target_crc32 = 0;
+  // Image a delta applies to; zero for full images.
+  uint32_t base_size = 0;
+  uint32_t base_crc32 = 0;
+
+  uint32_t chunk_count() const {
+    return chunk_size == 0 ? 0 : (size + chunk_size - 1) / chunk_size;
+  }
+  uint16_t chunk_len(uint32_t index) const;
+};
+
+bool operator==(const ImageInfo& a, const ImageInfo& b);
+
+struct ChunkView {
+  uint32_t index = 0;
+  uint16_t len = 0;
+  uint32_t crc32 = 0;
+  const uint8_t* data = nullptr;
+};
+
+struct Ack {
+  Status status = Status::kOk;
+  uint32_t next_chunk = 0;
+};
+
+size_t encode_offer(const ImageInfo& info, uint8_t* out);
+size_t encode_chunk(uint32_t index, const uint8_t* data, uint16_t len,
+                    uint8_t* out);
+size_t encode_finish(uint8_t* out);
+size_t encode_ack(const Ack& ack, uint8_t* out);
+
+Status decode_offer(const uint8_t* frame, size_t len, ImageInfo* info);
+// |out->data| points into |frame|; the payload is not copied.
+Status decode_chunk(const uint8_t* frame, size_t len, ChunkView* out);
+Status decode_finish(const uint8_t* frame, size_t len);
+Status decode_ack(const uint8_t* frame, size_t len, Ack* ack);
+
+}  // namespace ota
+}  // namespace ct
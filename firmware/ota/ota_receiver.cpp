@@ -0,0 +1,293 @@
+#include "ota/ota_receiver.h"
+
+#include "common/byte_io.h"
+#include "common/crc32.h"
+
+namespace ct {
+namespace ota {
+namespace {
+
+constexpr uint32_t kSessionMagic = 0x334F5443;  // "CTO3"
+constexpr uint32_t kHeaderSize = 48;
+constexpr uint32_t kRecordSize = 20;
+
+void encode_header(const ImageInfo& info, uint32_t slot_offset,
+                   uint8_t* out) {
+  for (uint32_t i = 0; i < kHeaderSize; ++i) out[i] = 0xFF;
+  put_u32(out + 0, kSessionMagic);
+  out[4] = static_cast<uint8_t>(info.kind);
+  put_u32(out + 8, info.size);
+  put_u32(out + 12, info.crc32);
+  put_u32(out + 16, info.version);
+  put_u16(out + 20, info.chunk_size);
+  put_u32(out + 24, info.target_size);
+  put_u32(out + 28, info.target_crc32);
+  put_u32(out + 32, info.base_size);
+  put_u32(out + 36, info.base_crc32);
+  put_u32(out + 40, slot_offset);
+  put_u32(out + kHeaderSize - 4, crc32(out, kHeaderSize - 4));
+}
+
+bool decode_header(const uint8_t* in, ImageInfo* info,
+                   uint32_t* slot_offset) {
+  if (get_u32(in) != kSessionMagic ||
+      get_u32(in + kHeaderSize - 4) != crc32(in, kHeaderSize - 4)) {
+    return false;
+  }
+  info->kind = static_cast<ImageKind>(in[4]);
+  info->size = get_u32(in + 8);
+  info->crc32 = get_u32(in + 12);
+  info->version = get_u32(in + 16);
+  info->chunk_size = get_u16(in + 20);
+  info->target_size = get_u32(in + 24);
+  info->target_crc32 = get_u32(in + 28);
+  info->base_size = get_u32(in + 32);
+  info->base_crc32 = get_u32(in + 36);
+  *slot_offset = get_u32(in + 40);
+  return true;
+}
+
+Status partition_crc(const Partition& part, uint32_t len, uint32_t* crc) {
+  uint8_t buf[256];
+  *crc = 0;
+  for (uint32_t off = 0; off < len; off += sizeof(buf)) {
+    const uint32_t left = len - off;
+    const uint32_t n = left < sizeof(buf) ? left : sizeof(buf);
+    CT_RETURN_IF_ERROR(part.read(off, buf, n));
+    *crc = crc32_update(*crc, buf, n);
+  }
+  return Status::kOk;
+}
+
+}  // namespace
+
+OtaReceiver::OtaReceiver(Partition slot, Partition base, Partition state)
+    : slot_(slot),
+      base_(base),
+      state_(state),
+      writer_(slot),
+      applier_(base, &writer_) {
+  if (state_.size() > kHeaderSize) {
+    journal_capacity_ = (state_.size() - kHeaderSize) / kRecordSize;
+  }
+}
+
+size_t OtaReceiver::handle_frame(const uint8_t* frame, size_t len,
+                                 uint8_t* ack_out) {
+  Ack ack;
+  if (len == 0) {
+    ack.status = Status::kCorrupt;
+  } else {
+    switch (static_cast<FrameType>(frame[0])) {
+      case FrameType::kOffer: {
+        ImageInfo info;
+        ack.status = decode_offer(frame, len, &info);
+        if (is_ok(ack.status)) ack.status = begin(info);
+        break;
+      }
+      case FrameType::kChunk: {
+        ChunkView chunk;
+        ack.status = decode_chunk(frame, len, &chunk);
+        if (is_ok(ack.status)) ack.status = write_chunk(chunk);
+        break;
+      }
+      case FrameType::kFinish:
+        ack.status = decode_finish(frame, len);
+        if (is_ok(ack.status)) ack.status = finish();
+        break;
+      default:
+        ack.status = Status::kCorrupt;
+        break;
+    }
+  }
+  ack.next_chunk = next_chunk_;
+  return encode_ack(ack, ack_out);
+}
+
+Status OtaReceiver::begin(const ImageInfo& info) {
+  if (!slot_.valid() || !state_.valid()) return Status::kBadState;
+  if (info.size == 0 || info.chunk_size == 0 ||
+      info.chunk_size > kMaxChunkSize) {
+    return Status::kBadArgument;
+  }
+  switch (info.kind) {
+    case ImageKind::kFull:
+      if (info.target_size != info.size || info.target_crc32 != info.crc32) {
+        return Status::kBadArgument;
+      }
+      break;
+    case ImageKind::kDelta:
+      if (!base_.valid()) return Status::kBadState;
+      if (info.base_size > base_.size()) return Status::kBadArgument;
+      break;
+    default:
+      return Status::kBadArgument;
+  }
+  if (info.target_size > slot_.size() || journal_capacity_ == 0) {
+    return Status::kNoSpace;
+  }
+  info_ = info;
+  verified_ = false;
+  const uint32_t chunks = info_.chunk_count();
+  checkpoint_interval_ = (chunks + journal_capacity_ - 1) / journal_capacity_;
+
+  bool resumed = false;
+  CT_RETURN_IF_ERROR(resume_session(&resumed));
+  if (!resumed) CT_RETURN_IF_ERROR(start_session());
+  active_ = true;
+  return Status::kOk;
+}
+
+void OtaReceiver::seek_payload(uint32_t payload_pos, uint32_t out_offset,
+                               uint32_t out_crc) {
+  next_chunk_ = payload_pos >= info_.size ? info_.chunk_count()
+                                          : payload_pos / info_.chunk_size;
+  if (info_.kind == ImageKind::kDelta) {
+    applier_.restart(payload_pos, out_offset, out_crc);
+  } else {
+    writer_.seek(out_offset, out_crc);
+  }
+}
+
+Status OtaReceiver::start_session() {
+  active_ = false;
+  if (info_.kind == ImageKind::kDelta) {
+    // A patch applied to the wrong base yields a broken image that only
+    // fails at the final CRC check; refuse it before any airtime is spent.
+    uint32_t crc = 0;
+    CT_RETURN_IF_ERROR(partition_crc(base_, info_.base_size, &crc));
+    if (crc != info_.base_crc32) return Status::kBadState;
+  }
+  CT_RETURN_IF_ERROR(write_header());
+  journal_mark_ = 0;
+  seek_payload(0, 0, 0);
+  return Status::kOk;
+}
+
+Status OtaReceiver::write_header() {
+  CT_RETURN_IF_ERROR(state_.erase_all());
+  uint8_t header[kHeaderSize];
+  encode_header(info_, slot_.offset(), header);
+  CT_RETURN_IF_ERROR(state_.program(0, header, sizeof(header)));
+  journal_used_ = 0;
+  return Status::kOk;
+}
+
+Status OtaReceiver::resume_session(bool* resumed) {
+  *resumed = false;
+  uint8_t header[kHeaderSize];
+  CT_RETURN_IF_ERROR(state_.read(0, header, sizeof(header)));
+  ImageInfo stored;
+  uint32_t stored_slot = 0;
+  if (!decode_header(header, &stored, &stored_slot) || !(stored == info_) ||
+      stored_slot != slot_.offset()) {
+    return Status::kOk;
+  }
+
+  // The journal is append-only: take the last intact record. A torn record
+  // (power lost mid-program) is skipped but still occupies its slot.
+  uint32_t mark = 0;
+  uint32_t payload_pos = 0;
+  uint32_t out_offset = 0;
+  uint32_t out_crc = 0;
+  uint32_t used = 0;
+  while (used < journal_capacity_) {
+    uint8_t rec[kRecordSize];
+    CT_RETURN_IF_ERROR(
+        state_.read(kHeaderSize + used * kRecordSize, rec, sizeof(rec)));
+    if (all_erased(rec, sizeof(rec))) break;
+    ++used;
+    if (get_u32(rec + 16) != crc32(rec, 16)) continue;
+    const uint32_t rec_mark = get_u32(rec);
+    const uint32_t rec_pos = get_u32(rec + 4);
+    const uint32_t rec_out = get_u32(rec + 8);
+    if (rec_mark > mark && rec_pos <= info_.size &&
+        rec_out <= info_.target_size) {
+      mark = rec_mark;
+      payload_pos = rec_pos;
+      out_offset = rec_out;
+      out_crc = get_u32(rec + 12);
+    }
+  }
+  journal_used_ = used;
+  journal_mark_ = mark;
+  seek_payload(payload_pos, out_offset, out_crc);
+  *resumed = true;
+  return Status::kOk;
+}
+
+Status OtaReceiver::append_checkpoint() {
+  if (journal_used_ >= journal_capacity_) {
+    // Only reachable after many torn records or delta rewinds. Compacting
+    // has a power-cut window, but losing the header merely restarts the
+    // session from chunk zero.
+    CT_RETURN_IF_ERROR(write_header());
+  }
+  uint8_t rec[kRecordSize];
+  put_u32(rec, next_chunk_);
+  if (info_.kind == ImageKind::kDelta) {
+    put_u32(rec + 4, applier_.op_start());
+    put_u32(rec + 8, applier_.op_out());
+    put_u32(rec + 12, applier_.op_crc());
+  } else {
+    put_u32(rec + 4, writer_.offset());
+    put_u32(rec + 8, writer_.offset());
+    put_u32(rec + 12, writer_.crc());
+  }
+  put_u32(rec + 16, crc32(rec, 16));
+  CT_RETURN_IF_ERROR(
+      state_.program(kHeaderSize + journal_used_ * kRecordSize, rec,
+                     sizeof(rec)));
+  ++journal_used_;
+  journal_mark_ = next_chunk_;
+  return Status::kOk;
+}
+
+Status OtaReceiver::write_chunk(const ChunkView& chunk) {
+  if (!active_) return Status::kBadState;
+  if (chunk.index < next_chunk_) return Status::kOk;
+  if (chunk.index > next_chunk_) return Status::kOutOfRange;
+  if (chunk.len != info_.chunk_len(chunk.index)) return Status::kCorrupt;
+  if (crc32(chunk.data, chunk.len) != chunk.crc32) {
+    return Status::kCrcMismatch;
+  }
+
+  // Data first, checkpoint second: after a power cut the journal never points
+  // past bytes that reached flash. Bytes written past the last checkpoint are
+  // simply programmed again with identical values on resume.
+  if (info_.kind == ImageKind::kDelta) {
+    CT_RETURN_IF_ERROR(applier_.feed(chunk.index * info_.chunk_size,
+                                     chunk.data, chunk.len));
+  } else {
+    CT_RETURN_IF_ERROR(writer_.write(chunk.data, chunk.len));
+  }
+  ++next_chunk_;
+  // A delta resume may rewind into chunks that were already journaled; only
+  // record progress past the newest mark.
+  const bool due = next_chunk_ % checkpoint_interval_ == 0 ||
+                   next_chunk_ == info_.chunk_count();
+  if (due && next_chunk_ > journal_mark_) {
+    CT_RETURN_IF_ERROR(append_checkpoint());
+  }
+  return Status::kOk;
+}
+
+Status OtaReceiver::finish() {
+  if (!active_ || next_chunk_ != info_.chunk_count()) return Status::kBadState;
+  if (info_.kind == ImageKind::kDelta && !applier_.at_op_boundary()) {
+    return Status::kCorrupt;
+  }
+  if (writer_.offset() != info_.target_size ||
+      writer_.crc() != info_.target_crc32) {
+    // The slot does not hold what the journal claims; force a clean restart.
+    active_ = false;
+    CT_RETURN_IF_ERROR(state_.erase_all());
+    next_chunk_ = 0;
+    return Status::kCrcMismatch;
+  }
+  verified_ = true;
+  return Status::kOk;
+}
+
+}  // namespace ota
+}  // namespace ct
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+#include "hal/flash.h"
+#include "ota/delta_applier.h"
+#include "ota/ota_protocol.h"
+#include "ota/slot_writer.h"
+
+namespace ct {
+namespace ota {
+
+// Device side of a streaming OTA session.
+//
+// Chunks are CRC-checked and programmed straight into |slot| as they arrive;
+// the only RAM used is the caller's frame buffer plus the fixed buffers of
+// this object. Delta payloads are decoded on the fly against |base|, the
+// running image. Progress is journaled in |state| so a session interrupted by
+// a link dropout or a reboot resumes at the last checkpoint instead of at
+// chunk zero.
+//
+// State partition layout:
+//   [0, 48)   session header: image info, slot flash offset + CRC,
+//             identifies the session
+//   [48, ...) checkpoint journal, 20-byte records
+//             [u32 mark][u32 payload_pos][u32 out_offset][u32 out_crc]
+//             [u32 crc]
+//
+// |mark| is the chunk count when the record was written; payload_pos and
+// out_offset are a point the payload can be resumed from (a chunk boundary
+// for full images, an op boundary for deltas) and out_crc is the CRC-32 of
+// the slot up to out_offset. The image CRC is thus built up as chunks are
+// programmed and survives reboots, and finish() never reads the slot back.
+// The header names the slot the journal describes, so a session offered
+// again after the update target has moved to the other slot starts over.
+// Records are only ever appended into erased space, so recording progress
+// never needs a read-modify-write.
+// When the image has more chunks than the journal has records, checkpoints
+// are spaced out evenly; a journal that still fills up is compacted.
+class OtaReceiver {
+ public:
+  OtaReceiver(Partition slot, Partition base, Partition state);
+
+  // Decodes one request frame, applies it and writes the reply into
+  // |ack_out| (kAckFrameSize bytes). Returns the reply length.
+  size_t handle_frame(const uint8_t* frame, size_t len, uint8_t* ack_out);
+
+  // Starts a session for |info|, or resumes the journaled one if it is for
+  // the same image. Afterwards next_chunk() is the first chunk to send.
+  // Starting a delta session checks the base image CRC first.
+  Status begin(const ImageInfo& info);
+
+  // Accepts the next chunk in sequence. Chunks already written are
+  // acknowledged without touching flash; chunks from the future are refused.
+  Status write_chunk(const ChunkView& chunk);
+
+  // Checks the target image size and CRC accumulated while writing.
+  Status finish();
+
+  uint32_t next_chunk() const { return next_chunk_; }
+  bool active() const { return active_; }
+  bool verified() const { return verified_; }
+  const ImageInfo& image() const { return info_; }
+  uint32_t checkpoint_interval() const { return checkpoint_interval_; }
+
+ private:
+  Status start_session();
+  Status resume_session(bool* resumed);
+  Status write_header();
+  Status append_checkpoint();
+  void seek_payload(uint32_t payload_pos, uint32_t out_offset,
+                    uint32_t out_crc);
+
+  Partition slot_;
+  Partition base_;
+  Partition state_;
+  SlotWriter writer_;
+  DeltaApplier applier_;
+  ImageInfo info_;
+  bool active_ = false;
+  bool verified_ = false;
+  uint32_t next_chunk_ = 0;
+  uint32_t checkpoint_interval_ = 1;
+  uint32_t journal_capacity_ = 0;
+  uint32_t journal_used_ = 0;
+  uint32_t journal_mark_ = 0;
+};
+
+}  // namespace ota
+}  // namespace ct
@@ -0,0 +1,36 @@
+#include "ota/slot_writer.h"
+
+#include "common/byte_io.h"
+#include "common/crc32.h"
+
+namespace ct {
+namespace ota {
+
+void SlotWriter::seek(uint32_t offset, uint32_t crc) {
+  offset_ = offset;
+  crc_ = crc;
+  erased_end_ = align_up(offset, slot_.sector_size());
+}
+
+Status SlotWriter::write(const uint8_t* data, size_t len) {
+  if (offset_ > slot_.size() || len > slot_.size() - offset_) {
+    return Status::kNoSpace;
+  }
+  while (len > 0) {
+    if (offset_ == erased_end_) {
+      CT_RETURN_IF_ERROR(slot_.erase_sector(erased_end_));
+      erased_end_ += slot_.sector_size();
+    }
+    const uint32_t room = erased_end_ - offset_;
+    const uint32_t n = len < room ? static_cast<uint32_t>(len) : room;
+    CT_RETURN_IF_ERROR(slot_.program(offset_, data, n));
+    crc_ = crc32_update(crc_, data, n);
+    offset_ += n;
+    data += n;
+    len -= n;
+  }
+  return Status::kOk;
+}
+
+}  // namespace ota
+}  // namespace ct
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+#include "hal/flash.h"
+
+namespace ct {
+namespace ota {
+
+// Sequential writer into an update slot. Sectors are erased lazily, right
+// before the first byte lands in them, so an update never pays for erasing
+// more of the slot than the image occupies and needs no staging buffer. A
+// CRC-32 of everything written since offset zero is kept as the bytes go
+// out, so the finished image is verified without reading the slot back.
+class SlotWriter {
+ public:
+  explicit SlotWriter(Partition slot) : slot_(slot) {}
+
+  // Positions the writer at |offset|, where |crc| is the CRC-32 of the slot
+  // up to it. A sector-aligned offset is erased again on the next write;
+  // otherwise the sector holding |offset| must already have been erased by
+  // this session (it holds the bytes before |offset|).
+  void seek(uint32_t offset, uint32_t crc);
+
+  Status write(const uint8_t* data, size_t len);
+
+  uint32_t offset() const { return offset_; }
+  uint32_t crc() const { return crc_; }
+  const Partition& slot() const { return slot_; }
+
+ private:
+  Partition slot_;
+  uint32_t offset_ = 0;
+  uint32_t erased_end_ = 0;
+  uint32_t crc_ = 0;
+};
+
+}  // namespace ota
+}  // namespace ct
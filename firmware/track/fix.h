@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ct {
+namespace track {
+
+// One GNSS position fix. Coordinates are integer 1e-7 degrees (about 1 cm),
+// the native resolution of common receivers, so no float rounding happens
+// between the receiver and storage or the uplink.
+struct Fix {
+  uint32_t time_s = 0;  // Unix time
+  int32_t lat_e7 = 0;
+  int32_t lon_e7 = 0;
+};
+
+inline bool operator==(const Fix& a, const Fix& b) {
+  return a.time_s == b.time_s && a.lat_e7 == b.lat_e7 && a.lon_e7 == b.lon_e7;
+}
+
+inline bool operator!=(const Fix& a, const Fix& b) { return !(a == b); }
+
+}  // namespace track
+}  // namespace ct
@@ -0,0 +1,50 @@
+#include "track/fix_scheduler.h"
+
+#include "track/geo.h"
+
+namespace ct {
+namespace track {
+namespace {
+
+uint32_t clamp(uint32_t v, uint32_t lo, uint32_t hi) {
+  return v < lo ? lo : v > hi ? hi : v;
+}
+
+}  // namespace
+
+FixScheduler::FixScheduler(const FixPolicy& policy)
+    : policy_(policy), interval_s_(policy.min_interval_s) {}
+
+void FixScheduler::on_motion(uint32_t now_s, uint16_t activity_mg) {
+  if (activity_mg >= policy_.rest_mg) last_active_s_ = now_s;
+  if (activity_mg >= policy_.wake_mg && state_ == State::kResting) {
+    state_ = State::kMoving;
+    interval_s_ = policy_.min_interval_s;
+    if (next_fix_s_ > now_s) next_fix_s_ = now_s;
+  } else if (state_ == State::kMoving &&
+             now_s - last_active_s_ >= policy_.settle_s) {
+    state_ = State::kResting;
+  }
+}
+
+void FixScheduler::on_fix(const Fix& fix) {
+  if (state_ == State::kResting) {
+    interval_s_ = clamp(interval_s_ * 2, policy_.min_interval_s,
+                        policy_.rest_interval_s);
+  } else if (have_fix_) {
+    const float moved = distance_m(last_fix_, fix);
+    if (moved > policy_.speed_up_m) {
+      interval_s_ = interval_s_ / 2;
+    } else if (moved < policy_.slow_down_m) {
+      interval_s_ = interval_s_ * 2;
+    }
+    interval_s_ = clamp(interval_s_, policy_.min_interval_s,
+                        policy_.moving_max_interval_s);
+  }
+  last_fix_ = fix;
+  have_fix_ = true;
+  next_fix_s_ = fix.time_s + interval_s_;
+}
+
+}  // namespace track
+}  // namespace ct
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include "track/fix.h"
+
+namespace ct {
+namespace track {
+
+struct FixPolicy {
+  uint32_t min_interval_s = 10;
+  uint32_t moving_max_interval_s = 120;
+  uint32_t rest_interval_s = 900;
+  // Activity at or above wake_mg means the cat is up; below rest_mg counts
+  // as still. The gap between the two is the hysteresis band.
+  uint16_t wake_mg = 80;
+  uint16_t rest_mg = 30;
+  // How long activity must stay below rest_mg before backing off to rest.
+  uint32_t settle_s = 180;
+  // While moving, a fix further than speed_up_m from the previous one halves
+  // the interval and one closer than slow_down_m doubles it. This is what
+  // backs off when the cat is busy grooming rather than going anywhere.
+  float speed_up_m = 30.0f;
+  float slow_down_m = 8.0f;
+};
+
+// Decides when the next GNSS fix is due from accelerometer activity and the
+// distance between fixes.
+//
+// Resting: the interval doubles after every fix up to rest_interval_s.
+// Moving: entered as soon as activity reaches wake_mg, which also pulls the
+// next fix forward to now; left only after settle_s of stillness.
+class FixScheduler {
+ public:
+  enum class State : uint8_t { kResting, kMoving };
+
+  explicit FixScheduler(const FixPolicy& policy);
+
+  // Accelerometer activity (e.g. high-passed magnitude, mg) for the period
+  // ending at |now_s|. Call at the motion sensor's wakeup rate.
+  void on_motion(uint32_t now_s, uint16_t activity_mg);
+
+  // A fix was obtained; sets the next due time from it.
+  void on_fix(const Fix& fix);
+
+  bool due(uint32_t now_s) const { return now_s >= next_fix_s_; }
+  uint32_t next_fix_s() const { return next_fix_s_; }
+  uint32_t interval_s() const { return interval_s_; }
+  State state() const { return state_; }
+
+ private:
+  FixPolicy policy_;
+  State state_ = State::kResting;
+  uint32_t interval_s_;
+  uint32_t next_fix_s_ = 0;
+  uint32_t last_active_s_ = 0;
+  bool have_fix_ = false;
+  Fix last_fix_;
+};
+
+}  // namespace track
+}  // namespace ct
@@ -0,0 +1,198 @@
+#include "track/track_log.h"
+
+#include <limits>
+
+#include "common/byte_io.h"
+#include "common/crc32.h"
+
+namespace ct {
+namespace track {
+namespace {
+
+constexpr uint32_t kPageMagic = 0x31545443;  // "CTT1"
+
+uint16_t record_crc(const uint8_t* rec) {
+  return static_cast<uint16_t>(crc32(rec, 6));
+}
+
+bool fits_i16(int64_t v) {
+  return v >= std::numeric_limits<int16_t>::min() &&
+         v <= std::numeric_limits<int16_t>::max();
+}
+
+bool decode_header(const uint8_t* h, uint32_t* seq, Fix* anchor) {
+  if (get_u32(h) != kPageMagic || get_u32(h + 20) != crc32(h, 20)) {
+    return false;
+  }
+  *seq = get_u32(h + 4);
+  anchor->time_s = get_u32(h + 8);
+  anchor->lat_e7 = static_cast<int32_t>(get_u32(h + 12));
+  anchor->lon_e7 = static_cast<int32_t>(get_u32(h + 16));
+  return *seq != 0;
+}
+
+}  // namespace
+
+TrackLog::TrackLog(Partition part) : part_(part) {}
+
+Status TrackLog::mount() {
+  mounted_ = false;
+  if (!part_.valid() || part_.sector_size() % kPageSize != 0 ||
+      part_.size() < 2 * part_.sector_size()) {
+    return Status::kBadArgument;
+  }
+  page_count_ = part_.size() / kPageSize;
+  pages_per_sector_ = part_.sector_size() / kPageSize;
+
+  head_ = page_count_ - 1;
+  head_seq_ = 0;
+  for (uint32_t p = 0; p < page_count_; ++p) {
+    uint8_t h[kHeaderSize];
+    CT_RETURN_IF_ERROR(part_.read(p * kPageSize, h, sizeof(h)));
+    uint32_t seq = 0;
+    Fix anchor;
+    if (decode_header(h, &seq, &anchor) && seq > head_seq_) {
+      head_ = p;
+      head_seq_ = seq;
+    }
+  }
+  open_ = false;
+  mounted_ = true;
+  return Status::kOk;
+}
+
+Status TrackLog::append(const Fix& fix) {
+  if (!mounted_) return Status::kBadState;
+  ++stats_.appended;
+  if (open_) {
+    const int64_t dt = static_cast<int64_t>(fix.time_s) - last_.time_s;
+    const int64_t dlat = static_cast<int64_t>(fix.lat_e7) - last_.lat_e7;
+    const int64_t dlon = static_cast<int64_t>(fix.lon_e7) - last_.lon_e7;
+    if (dt >= 0 && dt <= 0xFFFF && fits_i16(dlat) && fits_i16(dlon)) {
+      uint8_t* rec = page_ + used_;
+      put_u16(rec, static_cast<uint16_t>(dt));
+      put_u16(rec + 2, static_cast<uint16_t>(dlat));
+      put_u16(rec + 4, static_cast<uint16_t>(dlon));
+      put_u16(rec + 6, record_crc(rec));
+      used_ += kRecordSize;
+      last_ = fix;
+      if (used_ + kRecordSize > kPageSize) return close_page();
+      return Status::kOk;
+    }
+    ++stats_.early_page_breaks;
+    CT_RETURN_IF_ERROR(close_page());
+  }
+  return open_page(fix);
+}
+
+Status TrackLog::sync() {
+  if (!open_ || used_ == synced_) return Status::kOk;
+  CT_RETURN_IF_ERROR(part_.program(head_ * kPageSize + synced_,
+                                   page_ + synced_, used_ - synced_));
+  synced_ = used_;
+  return Status::kOk;
+}
+
+uint32_t TrackLog::pending() const {
+  if (!open_ || used_ == synced_) return 0;
+  // An unsynced header carries the page's anchor fix.
+  const uint32_t from = synced_ == 0 ? kHeaderSize : synced_;
+  return (used_ - from) / kRecordSize + (synced_ == 0 ? 1 : 0);
+}
+
+Status TrackLog::open_page(const Fix& anchor) {
+  // Pages after the head in its sector are normally still erased. One that
+  // is not was torn by a power cut; step over it rather than erase the
+  // whole sector, which would also drop the head page.
+  uint32_t p = (head_ + 1) % page_count_;
+  while (true) {
+    if (p % pages_per_sector_ == 0) {
+      CT_RETURN_IF_ERROR(part_.erase_sector(p * kPageSize));
+      ++stats_.sectors_erased;
+      break;
+    }
+    CT_RETURN_IF_ERROR(part_.read(p * kPageSize, page_, kPageSize));
+    if (all_erased(page_, kPageSize)) break;
+    ++stats_.pages_skipped;
+    p = (p + 1) % page_count_;
+  }
+
+  head_ = p;
+  ++head_seq_;
+  for (uint32_t i = 0; i < kPageSize; ++i) page_[i] = 0xFF;
+  put_u32(page_, kPageMagic);
+  put_u32(page_ + 4, head_seq_);
+  put_u32(page_ + 8, anchor.time_s);
+  put_u32(page_ + 12, static_cast<uint32_t>(anchor.lat_e7));
+  put_u32(page_ + 16, static_cast<uint32_t>(anchor.lon_e7));
+  put_u32(page_ + 20, crc32(page_, 20));
+  used_ = kHeaderSize;
+  synced_ = 0;
+  last_ = anchor;
+  open_ = true;
+  ++stats_.pages_opened;
+  return Status::kOk;
+}
+
+Status TrackLog::close_page() {
+  CT_RETURN_IF_ERROR(sync());
+  open_ = false;
+  return Status::kOk;
+}
+
+Status TrackReader::next(Fix* fix, bool* end) {
+  *end = false;
+  while (true) {
+    if (!in_page_) {
+      bool found = false;
+      CT_RETURN_IF_ERROR(enter_next_page(fix, &found));
+      if (!found) *end = true;
+      return Status::kOk;
+    }
+    if (record_ == TrackLog::kRecordsPerPage) {
+      in_page_ = false;
+      continue;
+    }
+    uint8_t rec[TrackLog::kRecordSize];
+    CT_RETURN_IF_ERROR(log_.part_.read(
+        page_ * TrackLog::kPageSize + TrackLog::kHeaderSize +
+            record_ * TrackLog::kRecordSize,
+        rec, sizeof(rec)));
+    ++record_;
+    // The first erased or torn record ends the page.
+    if (all_erased(rec, sizeof(rec)) || get_u16(rec + 6) != record_crc(rec)) {
+      in_page_ = false;
+      continue;
+    }
+    last_.time_s += get_u16(rec);
+    last_.lat_e7 += static_cast<int16_t>(get_u16(rec + 2));
+    last_.lon_e7 += static_cast<int16_t>(get_u16(rec + 4));
+    *fix = last_;
+    return Status::kOk;
+  }
+}
+
+Status TrackReader::enter_next_page(Fix* fix, bool* found) {
+  // Ring order starting just past the head is oldest-first.
+  *found = false;
+  while (visited_ < log_.page_count_) {
+    const uint32_t p = (log_.head_ + 1 + visited_) % log_.page_count_;
+    ++visited_;
+    uint8_t h[TrackLog::kHeaderSize];
+    CT_RETURN_IF_ERROR(log_.part_.read(p * TrackLog::kPageSize, h, sizeof(h)));
+    uint32_t seq = 0;
+    Fix anchor;
+    if (!decode_header(h, &seq, &anchor) || seq > log_.head_seq_) continue;
+    page_ = p;
+    record_ = 0;
+    in_page_ = true;
+    last_ = anchor;
+    *fix = anchor;
+    *found = true;
+    return Status::kOk;
+  }
+  return Status::kOk;
+}
+
+}  // namespace track
+}  // namespace ct
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+#include "hal/flash.h"
+#include "track/fix.h"
+
+namespace ct {
+namespace track {
+
+// Append-only ring log of position fixes on NOR flash.
+//
+// The partition is divided into 256-byte pages. Each page starts with a
+// header holding a sequence number and an absolute anchor fix, followed by
+// fixed 8-byte records that are deltas from the previous fix:
+//
+//   header [u32 magic][u32 seq][u32 time][i32 lat][i32 lon][u32 crc]
+//   record [u16 dt][i16 dlat][i16 dlon][u16 crc]
+//
+// Fixes are collected in a page buffer and programmed once the page is full,
+// or earlier on sync(). Either way bytes only ever land in erased space, so no
+// write needs a read-modify-write cycle; the sector ahead of the write page is
+// erased when the ring wraps, dropping the oldest fixes. A fix that does not
+// fit a delta record (long gap, big jump) starts a new page.
+//
+// After power loss, mount() finds the newest page by sequence number and the
+// reader replays every intact record. Only fixes appended since the last
+// sync() are lost.
+class TrackLog {
+ public:
+  static constexpr uint32_t kPageSize = 256;
+  static constexpr uint32_t kHeaderSize = 24;
+  static constexpr uint32_t kRecordSize = 8;
+  static constexpr uint32_t kRecordsPerPage =
+      (kPageSize - kHeaderSize) / kRecordSize;
+
+  struct Stats {
+    uint64_t appended = 0;
+    uint64_t pages_opened = 0;
+    uint64_t pages_skipped = 0;  // torn pages stepped over after a reboot
+    uint64_t early_page_breaks = 0;
+    uint64_t sectors_erased = 0;
+  };
+
+  explicit TrackLog(Partition part);
+
+  // Locates the newest page. Must succeed before append() or reading. New
+  // fixes always go into a fresh page, so a torn tail is never appended to.
+  Status mount();
+
+  Status append(const Fix& fix);
+
+  // Programs buffered fixes so they survive power loss.
+  Status sync();
+
+  // Fixes appended since the last sync() that a power cut would lose.
+  uint32_t pending() const;
+
+  bool mounted() const { return mounted_; }
+  uint32_t page_count() const { return page_count_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  friend class TrackReader;
+
+  Status open_page(const Fix& anchor);
+  Status close_page();
+
+  Partition part_;
+  uint32_t page_count_ = 0;
+  uint32_t pages_per_sector_ = 0;
+  bool mounted_ = false;
+
+  uint32_t head_ = 0;      // newest page with a header on flash or in RAM
+  uint32_t head_seq_ = 0;  // 0 while the log is empty
+  bool open_ = false;
+  uint32_t used_ = 0;     // bytes of the open page filled in page_
+  uint32_t synced_ = 0;   // bytes of the open page already programmed
+  Fix last_;
+  Stats stats_;
+  uint8_t page_[kPageSize];
+};
+
+// Replays a mounted log from the oldest surviving fix to the newest synced
+// one. The log must not be appended to while a reader is in use.
+class TrackReader {
+ public:
+  explicit TrackReader(const TrackLog& log) : log_(log) {}
+
+  // Produces the next fix, or sets |*end| once the log is exhausted.
+  Status next(Fix* fix, bool* end);
+
+ private:
+  Status enter_next_page(Fix* fix, bool* found);
+
+  const TrackLog& log_;
+  uint32_t visited_ = 0;  // pages entered so far, oldest first
+  uint32_t page_ = 0;
+  uint32_t record_ = 0;
+  bool in_page_ = false;
+  Fix last_;
+};
+
+}  // namespace track
+}  // namespace ct
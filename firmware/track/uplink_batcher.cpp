@@ -0,0 +1,86 @@
+#include "track/uplink_batcher.h"
+
+#include <cstring>
+
+#include "common/byte_io.h"
+#include "common/crc32.h"
+#include "common/varint.h"
+
+namespace ct {
+namespace track {
+
+UplinkBatcher::UplinkBatcher(uint32_t device_id, const BatchPolicy& policy)
+    : device_id_(device_id), policy_(policy) {
+  const size_t min_frame = kUplinkHeaderSize + kUplinkTrailerSize;
+  if (policy_.max_frame_bytes > kUplinkMaxFrameSize) {
+    policy_.max_frame_bytes = kUplinkMaxFrameSize;
+  } else if (policy_.max_frame_bytes < min_frame) {
+    policy_.max_frame_bytes = min_frame;
+  }
+}
+
+void UplinkBatcher::start_frame(const Fix& first) {
+  frame_[0] = kUplinkVersion;
+  put_u32(frame_ + 1, device_id_);
+  put_u16(frame_ + 5, seq_);
+  put_u32(frame_ + 8, first.time_s);
+  put_u32(frame_ + 12, static_cast<uint32_t>(first.lat_e7));
+  put_u32(frame_ + 16, static_cast<uint32_t>(first.lon_e7));
+  used_ = kUplinkHeaderSize;
+  count_ = 1;
+  last_ = first;
+}
+
+Status UplinkBatcher::add(const Fix& fix, bool* full) {
+  *full = false;
+  if (has_carry_) return Status::kBadState;
+  if (count_ == 0) {
+    start_frame(fix);
+    return Status::kOk;
+  }
+  if (fix.time_s < last_.time_s) return Status::kBadArgument;
+
+  uint8_t rec[kUplinkMaxRecordSize];
+  size_t n = put_varint(rec, fix.time_s - last_.time_s);
+  n += put_varint(rec + n,
+                  zigzag_encode(wrapping_sub(fix.lat_e7, last_.lat_e7)));
+  n += put_varint(rec + n,
+                  zigzag_encode(wrapping_sub(fix.lon_e7, last_.lon_e7)));
+  if (count_ == kUplinkMaxFixes ||
+      used_ + n + kUplinkTrailerSize > policy_.max_frame_bytes) {
+    carry_ = fix;
+    has_carry_ = true;
+    *full = true;
+    return Status::kOk;
+  }
+  std::memcpy(frame_ + used_, rec, n);
+  used_ += n;
+  ++count_;
+  last_ = fix;
+  return Status::kOk;
+}
+
+bool UplinkBatcher::due(uint32_t now_s) const {
+  if (count_ == 0) return false;
+  return has_carry_ || now_s - get_u32(frame_ + 8) >= policy_.max_age_s;
+}
+
+size_t UplinkBatcher::take_frame(uint8_t* out) {
+  if (count_ == 0) return 0;
+  frame_[7] = static_cast<uint8_t>(count_);
+  put_u32(frame_ + used_, crc32(frame_, used_));
+  const size_t len = used_ + kUplinkTrailerSize;
+  std::memcpy(out, frame_, len);
+
+  ++seq_;
+  count_ = 0;
+  used_ = 0;
+  if (has_carry_) {
+    has_carry_ = false;
+    start_frame(carry_);
+  }
+  return len;
+}
+
+}  // namespace track
+}  // namespace ct
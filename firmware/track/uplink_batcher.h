@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+#include "track/fix.h"
+#include "track/uplink_frame.h"
+
+namespace ct {
+namespace track {
+
+struct BatchPolicy {
+  // Largest frame the radio sends in one session, CRC included.
+  uint16_t max_frame_bytes = 200;
+  // Oldest a queued fix may get before the frame goes out anyway.
+  uint32_t max_age_s = 600;
+};
+
+// Collects fixes into one compressed uplink frame per radio session.
+//
+// Fixes are encoded as they arrive, so the only state is the frame being
+// built. A frame is ready when the next fix would overflow it (add() reports
+// |full|) or when its oldest fix reaches max_age_s (due()). The caller then
+// wakes the radio once and sends take_frame().
+class UplinkBatcher {
+ public:
+  UplinkBatcher(uint32_t device_id, const BatchPolicy& policy);
+
+  // Queues |fix|. When it does not fit, it is held over for the next frame
+  // and |*full| is set; the caller must take_frame() before adding again.
+  Status add(const Fix& fix, bool* full);
+
+  bool due(uint32_t now_s) const;
+  bool empty() const { return count_ == 0; }
+  uint32_t pending() const { return count_ + (has_carry_ ? 1 : 0); }
+
+  // Seals the pending fixes into |out| (room for max_frame_bytes) and
+  // returns the frame length, or 0 when nothing is queued.
+  size_t take_frame(uint8_t* out);
+
+ private:
+  void start_frame(const Fix& first);
+
+  uint32_t device_id_;
+  BatchPolicy policy_;
+  uint16_t seq_ = 0;
+  uint32_t count_ = 0;
+  size_t used_ = 0;
+  Fix last_;
+  Fix carry_;
+  bool has_carry_ = false;
+  uint8_t frame_[kUplinkMaxFrameSize];
+};
+
+}  // namespace track
+}  // namespace ct
@@ -0,0 +1,48 @@
+#include "track/uplink_frame.h"
+
+#include "common/byte_io.h"
+#include "common/crc32.h"
+#include "common/varint.h"
+
+namespace ct {
+namespace track {
+
+Status decode_uplink_frame(const uint8_t* frame, size_t len,
+                           UplinkHeader* header, Fix* fixes, size_t cap) {
+  if (len < kUplinkHeaderSize + kUplinkTrailerSize ||
+      frame[0] != kUplinkVersion) {
+    return Status::kCorrupt;
+  }
+  const size_t body_end = len - kUplinkTrailerSize;
+  if (get_u32(frame + body_end) != crc32(frame, body_end)) {
+    return Status::kCrcMismatch;
+  }
+  header->device_id = get_u32(frame + 1);
+  header->seq = get_u16(frame + 5);
+  header->count = frame[7];
+  if (header->count == 0) return Status::kCorrupt;
+  if (header->count > cap) return Status::kNoSpace;
+
+  Fix fix;
+  fix.time_s = get_u32(frame + 8);
+  fix.lat_e7 = static_cast<int32_t>(get_u32(frame + 12));
+  fix.lon_e7 = static_cast<int32_t>(get_u32(frame + 16));
+  fixes[0] = fix;
+  size_t pos = kUplinkHeaderSize;
+  for (uint32_t i = 1; i < header->count; ++i) {
+    uint32_t v[3];
+    for (uint32_t& field : v) {
+      const int n = get_varint(frame + pos, body_end - pos, &field);
+      if (n <= 0) return Status::kCorrupt;
+      pos += static_cast<size_t>(n);
+    }
+    fix.time_s += v[0];
+    fix.lat_e7 = wrapping_add(fix.lat_e7, zigzag_decode(v[1]));
+    fix.lon_e7 = wrapping_add(fix.lon_e7, zigzag_decode(v[2]));
+    fixes[i] = fix;
+  }
+  return pos == body_end ? Status::kOk : Status::kCorrupt;
+}
+
+}  // namespace track
+}  // namespace ct
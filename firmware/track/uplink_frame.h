@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+#include "track/fix.h"
+
+namespace ct {
+namespace track {
+
+// Uplink frame carrying a batch of fixes from one device.
+//
+//   [u8 version][u32 device_id][u16 seq][u8 count]
+//   [u32 time][i32 lat][i32 lon]                      first fix, absolute
+//   (count - 1) x [varint dt][varint zz(dlat)][varint zz(dlon)]
+//   [u32 crc32(preceding bytes)]
+//
+// Each later fix is a delta from the one before it; zz() is zigzag encoding
+// so small moves in either direction take one or two bytes. Fixes must be in
+// time order within a frame.
+constexpr uint8_t kUplinkVersion = 1;
+constexpr size_t kUplinkHeaderSize = 20;
+constexpr size_t kUplinkTrailerSize = 4;
+constexpr size_t kUplinkMaxRecordSize = 15;
+constexpr size_t kUplinkMaxFrameSize = 256;
+constexpr size_t kUplinkMaxFixes = 255;
+
+// Server reply to a frame: [u8 status][u16 seq].
+constexpr size_t kUplinkAckSize = 3;
+
+struct UplinkHeader {
+  uint32_t device_id = 0;
+  uint16_t seq = 0;
+  uint8_t count = 0;
+};
+
+// Reference decoder. Writes up to |cap| fixes; frames with more are refused.
+Status decode_uplink_frame(const uint8_t* frame, size_t len,
+                           UplinkHeader* header, Fix* fixes, size_t cap);
+
+}  // namespace track
+}  // namespace ct
@@ -0,0 +1,158 @@
+#include "delta/delta_encoder.h"
+
+#include <algorithm>
+
+#include "common/varint.h"
+#include "ota/delta_format.h"
+
+namespace ct {
+namespace delta {
+namespace {
+
+constexpr uint64_t kHashBase = 0x100000001B3ull;
+constexpr uint32_t kNoEntry = UINT32_MAX;
+
+uint64_t hash_block(const uint8_t* p, uint32_t len) {
+  uint64_t h = 0;
+  for (uint32_t i = 0; i < len; ++i) h = h * kHashBase + p[i];
+  return h;
+}
+
+class PatchWriter {
+ public:
+  PatchWriter(std::vector<uint8_t>* out, uint32_t max_add, PatchStats* stats)
+      : out_(out), max_add_(max_add), stats_(stats) {}
+
+  void add(const uint8_t* p, uint32_t len) {
+    while (len > 0) {
+      const uint32_t n = std::min(len, max_add_);
+      op(ota::delta::Op::kAdd);
+      varint(n);
+      out_->insert(out_->end(), p, p + n);
+      ++stats_->add_ops;
+      stats_->add_bytes += n;
+      p += n;
+      len -= n;
+    }
+  }
+
+  void copy(uint32_t src, uint32_t len) {
+    op(ota::delta::Op::kCopy);
+    varint(src);
+    varint(len);
+    ++stats_->copy_ops;
+    stats_->copy_bytes += len;
+  }
+
+ private:
+  void op(ota::delta::Op o) { out_->push_back(static_cast<uint8_t>(o)); }
+  void varint(uint32_t v) {
+    uint8_t buf[kMaxVarint32Size];
+    out_->insert(out_->end(), buf, buf + put_varint(buf, v));
+  }
+
+  std::vector<uint8_t>* out_;
+  uint32_t max_add_;
+  PatchStats* stats_;
+};
+
+}  // namespace
+
+std::vector<uint8_t> encode_delta(const std::vector<uint8_t>& base,
+                                  const std::vector<uint8_t>& target,
+                                  const EncoderOptions& options,
+                                  PatchStats* stats) {
+  *stats = PatchStats();
+  std::vector<uint8_t> patch;
+  if (target.empty()) return patch;
+  PatchWriter writer(&patch, std::max<uint32_t>(options.max_add, 1), stats);
+  const uint32_t block = std::max<uint32_t>(options.block_size, 4);
+  const uint32_t base_len = static_cast<uint32_t>(base.size());
+  const uint32_t target_len = static_cast<uint32_t>(target.size());
+
+  // Open-addressed index of block-aligned base offsets, keyed by block hash.
+  int bits = 10;
+  while ((1u << bits) < 2 * (base_len / block + 1)) ++bits;
+  std::vector<uint32_t> table(size_t{1} << bits, kNoEntry);
+  auto slot = [bits](uint64_t h) {
+    return static_cast<size_t>((h * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+  };
+  for (uint32_t off = 0; off + block <= base_len; off += block) {
+    uint32_t& entry = table[slot(hash_block(&base[off], block))];
+    if (entry == kNoEntry) entry = off;
+  }
+
+  uint64_t top = 1;  // kHashBase^(block - 1), to roll the oldest byte out
+  for (uint32_t i = 1; i < block; ++i) top *= kHashBase;
+
+  auto match_len = [&](uint32_t src, uint32_t dst) {
+    uint32_t n = 0;
+    while (src + n < base_len && dst + n < target_len &&
+           base[src + n] == target[dst + n]) {
+      ++n;
+    }
+    return n;
+  };
+
+  uint32_t literal = 0;  // start of target bytes not yet covered by an op
+  uint32_t pos = 0;
+  bool have_realign = false;
+  int64_t realign = 0;  // base minus target offset of the last Copy
+  uint64_t h = target_len >= block ? hash_block(&target[0], block) : 0;
+
+  while (pos + block <= target_len) {
+    uint32_t src = kNoEntry;
+    uint32_t len = 0;
+
+    const int64_t guess64 = static_cast<int64_t>(pos) + realign;
+    if (have_realign && guess64 >= 0 && guess64 < base_len) {
+      const uint32_t guess = static_cast<uint32_t>(guess64);
+      const uint32_t n = match_len(guess, pos);
+      if (n >= options.min_realign_match) {
+        src = guess;
+        len = n;
+      }
+    }
+    if (src == kNoEntry) {
+      const uint32_t cand = table[slot(h)];
+      if (cand != kNoEntry) {
+        uint32_t n = match_len(cand, pos);
+        uint32_t start = pos;
+        uint32_t from = cand;
+        // Grow the match backwards into bytes still pending as literals.
+        while (start > literal && from > 0 &&
+               base[from - 1] == target[start - 1]) {
+          --start;
+          --from;
+          ++n;
+        }
+        if (n >= options.min_match) {
+          pos = start;
+          src = from;
+          len = n;
+        }
+      }
+    }
+
+    if (src != kNoEntry) {
+      writer.add(target.data() + literal, pos - literal);
+      writer.copy(src, len);
+      realign = static_cast<int64_t>(src) - pos;
+      have_realign = true;
+      pos += len;
+      literal = pos;
+      if (pos + block <= target_len) h = hash_block(&target[pos], block);
+      continue;
+    }
+
+    if (pos + block < target_len) {
+      h = (h - target[pos] * top) * kHashBase + target[pos + block];
+    }
+    ++pos;
+  }
+  writer.add(target.data() + literal, target_len - literal);
+  return patch;
+}
+
+}  // namespace delta
+}  // namespace ct
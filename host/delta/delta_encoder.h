@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ct {
+namespace delta {
+
+struct EncoderOptions {
+  // Base blocks of this size are indexed; matches shorter than min_match
+  // cost more as a Copy than as literals and are not taken.
+  uint32_t block_size = 16;
+  uint32_t min_match = 20;
+  // After a match ends, the same base/target alignment is probed again with
+  // this lower threshold; it catches runs split by a few patched bytes, the
+  // usual shape of a recompiled firmware image.
+  uint32_t min_realign_match = 8;
+  // Upper bound on a single Add op. Resume restarts at an op boundary, so
+  // this also caps how much patch data is resent after a reboot.
+  uint32_t max_add = 512;
+};
+
+struct PatchStats {
+  uint64_t copy_ops = 0;
+  uint64_t copy_bytes = 0;
+  uint64_t add_ops = 0;
+  uint64_t add_bytes = 0;
+};
+
+// Builds a patch (see firmware/ota/delta_format.h) that turns |base| into
+// |target|. Runs on the host, so both images are held in memory.
+std::vector<uint8_t> encode_delta(const std::vector<uint8_t>& base,
+                                  const std::vector<uint8_t>& target,
+                                  const EncoderOptions& options,
+                                  PatchStats* stats);
+
+}  // namespace delta
+}  // namespace ct
@@ -0,0 +1,63 @@
+#include "sim/faulty_transport.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ct {
+namespace sim {
+
+FaultyTransport::FaultyTransport(FrameHandler peer, const FaultConfig& config)
+    : peer_(std::move(peer)), config_(config), rng_(config.seed) {}
+
+Status FaultyTransport::exchange(const uint8_t* frame, size_t len,
+                                 uint8_t* reply, size_t reply_cap,
+                                 size_t* reply_len) {
+  *reply_len = 0;
+  if (!connected_) return Status::kDisconnected;
+  ++stats_.frames;
+  stats_.bytes_up += len;
+  stats_.airtime_us +=
+      config_.latency_us + static_cast<double>(len) * 8e6 / config_.bitrate_bps;
+
+  // Split the drop probability evenly between losing the request and losing
+  // the reply; the latter leaves the device a step ahead of the host.
+  const bool drop = roll(config_.drop_rate);
+  const bool drop_reply = drop && coin_(rng_) < 0.5;
+  if (drop && !drop_reply) {
+    ++stats_.drops;
+    connected_ = false;
+    return Status::kDisconnected;
+  }
+
+  std::vector<uint8_t> copy(frame, frame + len);
+  if (len > 0 && roll(config_.corrupt_rate)) {
+    std::uniform_int_distribution<size_t> bit(0, len * 8 - 1);
+    const size_t b = bit(rng_);
+    copy[b / 8] ^= static_cast<uint8_t>(1u << (b % 8));
+    ++stats_.corruptions;
+  }
+
+  uint8_t buf[kMaxReplySize];
+  const size_t n = peer_(copy.data(), copy.size(), buf);
+  if (drop_reply) {
+    ++stats_.drops;
+    connected_ = false;
+    return Status::kDisconnected;
+  }
+  if (n > reply_cap) return Status::kNoSpace;
+  std::copy(buf, buf + n, reply);
+  *reply_len = n;
+  stats_.bytes_down += n;
+  stats_.airtime_us += static_cast<double>(n) * 8e6 / config_.bitrate_bps;
+  return Status::kOk;
+}
+
+Status FaultyTransport::reconnect() {
+  connected_ = true;
+  ++stats_.reconnects;
+  if (on_reconnect_) on_reconnect_();
+  return Status::kOk;
+}
+
+}  // namespace sim
+}  // namespace ct
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <random>
+
+#include "sim/transport.h"
+
+namespace ct {
+namespace sim {
+
+struct FaultConfig {
+  // Probability per exchange that the link drops, either before the request
+  // arrives or after the device handled it but before the reply got back.
+  double drop_rate = 0.0;
+  // Probability per exchange that one bit of the request is flipped.
+  double corrupt_rate = 0.0;
+  // Link model used for airtime accounting.
+  double bitrate_bps = 250000.0;
+  double latency_us = 4000.0;
+  uint32_t seed = 1;
+};
+
+// In-process link to a FrameHandler that injects dropouts and bit errors
+// from a seeded PRNG, so failing runs can be replayed exactly.
+class FaultyTransport : public Transport {
+ public:
+  FaultyTransport(FrameHandler peer, const FaultConfig& config);
+
+  Status exchange(const uint8_t* frame, size_t len, uint8_t* reply,
+                  size_t reply_cap, size_t* reply_len) override;
+  Status reconnect() override;
+  const LinkStats& stats() const override { return stats_; }
+
+  // Runs whenever the link comes back, e.g. to model a device reboot.
+  void set_on_reconnect(std::function<void()> hook) {
+    on_reconnect_ = std::move(hook);
+  }
+
+ private:
+  bool roll(double p) { return p > 0.0 && coin_(rng_) < p; }
+
+  FrameHandler peer_;
+  FaultConfig config_;
+  std::mt19937 rng_;
+  std::uniform_real_distribution<double> coin_{0.0, 1.0};
+  std::function<void()> on_reconnect_;
+  bool connected_ = true;
+  LinkStats stats_;
+};
+
+}  // namespace sim
+}  // namespace ct
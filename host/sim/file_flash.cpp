@@ -0,0 +1,149 @@
+#include "sim/file_flash.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace ct {
+namespace sim {
+namespace {
+
+bool pread_all(int fd, void* dst, size_t len, off_t off) {
+  uint8_t* p = static_cast<uint8_t*>(dst);
+  while (len > 0) {
+    const ssize_t n = ::pread(fd, p, len, off);
+    if (n <= 0) return false;
+    p += n;
+    off += n;
+    len -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool pwrite_all(int fd, const void* src, size_t len, off_t off) {
+  const uint8_t* p = static_cast<const uint8_t*>(src);
+  while (len > 0) {
+    const ssize_t n = ::pwrite(fd, p, len, off);
+    if (n <= 0) return false;
+    p += n;
+    off += n;
+    len -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+}  // namespace
+
+FileFlash::~FileFlash() { close(); }
+
+Status FileFlash::open(const std::string& path, uint32_t size,
+                       uint32_t sector_size, bool fresh) {
+  close();
+  if (sector_size == 0 || size == 0 || size % sector_size != 0) {
+    return Status::kBadArgument;
+  }
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) return Status::kIoError;
+  size_ = size;
+  sector_size_ = sector_size;
+
+  struct stat st;
+  if (::fstat(fd_, &st) != 0) return Status::kIoError;
+  if (fresh || static_cast<uint64_t>(st.st_size) != size) {
+    if (::ftruncate(fd_, 0) != 0) return Status::kIoError;
+    const std::vector<uint8_t> erased(sector_size, 0xFF);
+    for (uint32_t addr = 0; addr < size; addr += sector_size) {
+      if (!pwrite_all(fd_, erased.data(), erased.size(), addr)) {
+        return Status::kIoError;
+      }
+    }
+  }
+  return Status::kOk;
+}
+
+void FileFlash::close() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+}
+
+void FileFlash::cut_power_after(uint64_t ops, uint32_t seed) {
+  cut_countdown_ = ops;
+  tear_state_ = seed | 1;
+}
+
+void FileFlash::restore_power() {
+  cut_countdown_ = 0;
+  power_lost_ = false;
+}
+
+bool FileFlash::tear_now() {
+  if (cut_countdown_ == 0 || --cut_countdown_ != 0) return false;
+  power_lost_ = true;
+  return true;
+}
+
+uint32_t FileFlash::tear_point(uint32_t len) {
+  // xorshift32: deterministic per seed, independent of any other PRNG.
+  tear_state_ ^= tear_state_ << 13;
+  tear_state_ ^= tear_state_ >> 17;
+  tear_state_ ^= tear_state_ << 5;
+  return len == 0 ? 0 : tear_state_ % len;
+}
+
+Status FileFlash::read(uint32_t addr, void* dst, size_t len) {
+  if (fd_ < 0) return Status::kBadState;
+  if (power_lost_) return Status::kIoError;
+  if (!in_range(addr, len)) return Status::kOutOfRange;
+  if (!pread_all(fd_, dst, len, addr)) return Status::kIoError;
+  stats_.bytes_read += len;
+  stats_.modeled_us += timing_.read_us_per_byte * static_cast<double>(len);
+  return Status::kOk;
+}
+
+Status FileFlash::program(uint32_t addr, const void* src, size_t len) {
+  if (fd_ < 0) return Status::kBadState;
+  if (power_lost_) return Status::kIoError;
+  if (!in_range(addr, len)) return Status::kOutOfRange;
+  std::vector<uint8_t> old(len);
+  if (!pread_all(fd_, old.data(), len, addr)) return Status::kIoError;
+  const uint8_t* p = static_cast<const uint8_t*>(src);
+  for (size_t i = 0; i < len; ++i) {
+    if ((old[i] & p[i]) != p[i]) return Status::kBadState;
+  }
+  if (tear_now()) {
+    const uint32_t n = tear_point(static_cast<uint32_t>(len));
+    if (n > 0) pwrite_all(fd_, src, n, addr);
+    return Status::kIoError;
+  }
+  if (!pwrite_all(fd_, src, len, addr)) return Status::kIoError;
+  stats_.bytes_programmed += len;
+  stats_.program_ops += 1;
+  stats_.modeled_us += timing_.program_us_per_op +
+                       timing_.program_us_per_byte * static_cast<double>(len);
+  return Status::kOk;
+}
+
+Status FileFlash::erase_sector(uint32_t addr) {
+  if (fd_ < 0) return Status::kBadState;
+  if (power_lost_) return Status::kIoError;
+  if (!in_range(addr, sector_size_) || addr % sector_size_ != 0) {
+    return Status::kOutOfRange;
+  }
+  const std::vector<uint8_t> erased(sector_size_, 0xFF);
+  if (tear_now()) {
+    const uint32_t n = tear_point(sector_size_);
+    if (n > 0) pwrite_all(fd_, erased.data(), n, addr);
+    return Status::kIoError;
+  }
+  if (!pwrite_all(fd_, erased.data(), erased.size(), addr)) {
+    return Status::kIoError;
+  }
+  stats_.sectors_erased += 1;
+  stats_.modeled_us += timing_.erase_us_per_sector;
+  return Status::kOk;
+}
+
+}  // namespace sim
+}  // namespace ct
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "hal/flash.h"
+
+namespace ct {
+namespace sim {
+
+// Typical serial NOR figures (4 KiB sector erase, byte/page program), used to
+// turn operation counts into a device-time estimate.
+struct FlashTiming {
+  double read_us_per_byte = 0.02;
+  double program_us_per_op = 30.0;
+  double program_us_per_byte = 2.5;
+  double erase_us_per_sector = 45000.0;
+};
+
+struct FlashStats {
+  uint64_t bytes_read = 0;
+  uint64_t bytes_programmed = 0;
+  uint64_t program_ops = 0;
+  uint64_t sectors_erased = 0;
+  double modeled_us = 0.0;
+};
+
+// Flash device backed by a regular file, for running firmware code on Linux.
+// Enforces NOR rules: program() refuses to set a bit an earlier program
+// cleared, so a missing erase shows up as kBadState instead of silently
+// working like a RAM buffer would.
+class FileFlash : public Flash {
+ public:
+  FileFlash() = default;
+  ~FileFlash() override;
+  FileFlash(const FileFlash&) = delete;
+  FileFlash& operator=(const FileFlash&) = delete;
+
+  // Opens |path|, creating it fully erased when it does not exist or its
+  // size does not match. |fresh| forces a fully erased device.
+  Status open(const std::string& path, uint32_t size, uint32_t sector_size,
+              bool fresh);
+  void close();
+
+  uint32_t size() const override { return size_; }
+  uint32_t sector_size() const override { return sector_size_; }
+
+  Status read(uint32_t addr, void* dst, size_t len) override;
+  Status program(uint32_t addr, const void* src, size_t len) override;
+  Status erase_sector(uint32_t addr) override;
+
+  const FlashStats& stats() const { return stats_; }
+  void reset_stats() { stats_ = FlashStats(); }
+  void set_timing(const FlashTiming& timing) { timing_ = timing; }
+
+  // Simulated power loss. The |ops|-th program or erase from now (1 is the
+  // next one) is torn: a program lands only a prefix of its bytes, an erase
+  // only wipes a prefix of the sector. That call and every access after it
+  // fail with kIoError until restore_power(), like a device whose supply
+  // died mid-operation. |seed| picks the tear points.
+  void cut_power_after(uint64_t ops, uint32_t seed);
+  void restore_power();
+  bool powered() const { return !power_lost_; }
+
+ private:
+  bool in_range(uint32_t addr, size_t len) const {
+    return addr <= size_ && len <= size_ - addr;
+  }
+
+  // True when the operation about to run is the one the power dies in.
+  bool tear_now();
+  uint32_t tear_point(uint32_t len);
+
+  int fd_ = -1;
+  uint32_t size_ = 0;
+  uint64_t cut_countdown_ = 0;  // 0: no cut armed
+  uint32_t tear_state_ = 1;
+  bool power_lost_ = false;
+  uint32_t sector_size_ = 0;
+  FlashTiming timing_;
+  FlashStats stats_;
+};
+
+}  // namespace sim
+}  // namespace ct
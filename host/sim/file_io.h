@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ct {
+namespace sim {
+
+// Whole-file helpers for host tools; device code streams instead.
+bool read_file(const std::string& path, std::vector<uint8_t>* data);
+bool write_file(const std::string& path, const std::vector<uint8_t>& data);
+
+}  // namespace sim
+}  // namespace ct
@@ -0,0 +1,91 @@
+#include "sim/loopback_transport.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace ct {
+namespace sim {
+namespace {
+
+constexpr size_t kMaxDatagram = 65536;
+
+int bind_loopback(sockaddr_in* addr) {
+  const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return -1;
+  *addr = sockaddr_in();
+  addr->sin_family = AF_INET;
+  addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(*addr);
+  if (::bind(fd, reinterpret_cast<sockaddr*>(addr), sizeof(*addr)) != 0 ||
+      ::getsockname(fd, reinterpret_cast<sockaddr*>(addr), &len) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+LoopbackTransport::~LoopbackTransport() { close(); }
+
+void LoopbackTransport::close() {
+  if (local_fd_ >= 0) ::close(local_fd_);
+  if (peer_fd_ >= 0) ::close(peer_fd_);
+  local_fd_ = peer_fd_ = -1;
+}
+
+Status LoopbackTransport::open() {
+  close();
+  sockaddr_in local_addr;
+  sockaddr_in peer_addr;
+  local_fd_ = bind_loopback(&local_addr);
+  peer_fd_ = bind_loopback(&peer_addr);
+  if (local_fd_ < 0 || peer_fd_ < 0 ||
+      ::connect(local_fd_, reinterpret_cast<sockaddr*>(&peer_addr),
+                sizeof(peer_addr)) != 0 ||
+      ::connect(peer_fd_, reinterpret_cast<sockaddr*>(&local_addr),
+                sizeof(local_addr)) != 0) {
+    close();
+    return Status::kIoError;
+  }
+  return Status::kOk;
+}
+
+Status LoopbackTransport::exchange(const uint8_t* frame, size_t len,
+                                   uint8_t* reply, size_t reply_cap,
+                                   size_t* reply_len) {
+  *reply_len = 0;
+  if (local_fd_ < 0) return Status::kDisconnected;
+  if (::send(local_fd_, frame, len, 0) != static_cast<ssize_t>(len)) {
+    return Status::kIoError;
+  }
+  std::vector<uint8_t> rx(kMaxDatagram);
+  const ssize_t got = ::recv(peer_fd_, rx.data(), rx.size(), 0);
+  if (got < 0) return Status::kIoError;
+
+  uint8_t out[kMaxReplySize];
+  const size_t n = peer_(rx.data(), static_cast<size_t>(got), out);
+  if (::send(peer_fd_, out, n, 0) != static_cast<ssize_t>(n)) {
+    return Status::kIoError;
+  }
+  const ssize_t back = ::recv(local_fd_, reply, reply_cap, 0);
+  if (back < 0) return Status::kIoError;
+  *reply_len = static_cast<size_t>(back);
+
+  ++stats_.frames;
+  stats_.bytes_up += len;
+  stats_.bytes_down += *reply_len;
+  return Status::kOk;
+}
+
+Status LoopbackTransport::reconnect() {
+  ++stats_.reconnects;
+  return open();
+}
+
+}  // namespace sim
+}  // namespace ct
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "sim/transport.h"
+
+namespace ct {
+namespace sim {
+
+// Transport over a pair of UDP sockets on 127.0.0.1. Every exchange makes a
+// real round trip through the kernel's network stack; the peer handler runs
+// on the calling thread, so runs stay deterministic.
+class LoopbackTransport : public Transport {
+ public:
+  explicit LoopbackTransport(FrameHandler peer) : peer_(std::move(peer)) {}
+  ~LoopbackTransport() override;
+  LoopbackTransport(const LoopbackTransport&) = delete;
+  LoopbackTransport& operator=(const LoopbackTransport&) = delete;
+
+  Status open();
+
+  Status exchange(const uint8_t* frame, size_t len, uint8_t* reply,
+                  size_t reply_cap, size_t* reply_len) override;
+  Status reconnect() override;
+  const LinkStats& stats() const override { return stats_; }
+
+ private:
+  void close();
+
+  FrameHandler peer_;
+  int local_fd_ = -1;
+  int peer_fd_ = -1;
+  LinkStats stats_;
+};
+
+}  // namespace sim
+}  // namespace ct
@@ -0,0 +1,137 @@
+#include "sim/motion_trace.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "track/geo.h"
+
+namespace ct {
+namespace sim {
+namespace {
+
+enum class Behavior { kNap, kGroom, kWalk, kSprint };
+
+struct BehaviorSpec {
+  double mean_duration_s;
+  double speed_mps;
+  double activity_mg;
+};
+
+BehaviorSpec spec(Behavior b) {
+  switch (b) {
+    case Behavior::kNap:
+      return {2400.0, 0.0, 4.0};
+    case Behavior::kGroom:
+      return {240.0, 0.0, 120.0};
+    case Behavior::kWalk:
+      return {300.0, 0.7, 150.0};
+    case Behavior::kSprint:
+      return {20.0, 4.0, 450.0};
+  }
+  return {60.0, 0.0, 0.0};
+}
+
+}  // namespace
+
+std::vector<MotionSample> make_motion_trace(uint32_t seconds, uint32_t seed) {
+  constexpr double kPi = 3.14159265358979323846;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::normal_distribution<double> jitter(0.0, 1.0);
+
+  const int32_t home_lat = 473769000;
+  const int32_t home_lon = 85417000;
+  const double lat_per_m = 1e7 / track::kMetersPerDegree;
+  const double lon_per_m = 1.0 / track::lon_scale_m(home_lat);
+
+  std::vector<MotionSample> trace;
+  trace.reserve(seconds);
+  Behavior behavior = Behavior::kNap;
+  uint32_t left = 0;
+  double x = 0.0;
+  double y = 0.0;
+  double heading = 0.0;
+
+  for (uint32_t t = 0; t < seconds; ++t) {
+    if (left == 0) {
+      const double r = unit(rng);
+      if (behavior != Behavior::kNap) {
+        behavior = r < 0.45 ? Behavior::kNap
+                   : r < 0.65 ? Behavior::kGroom
+                   : r < 0.95 ? Behavior::kWalk
+                              : Behavior::kSprint;
+      } else {
+        behavior = r < 0.3 ? Behavior::kGroom
+                   : r < 0.9 ? Behavior::kWalk
+                             : Behavior::kSprint;
+      }
+      const double mean = spec(behavior).mean_duration_s;
+      left = 1 + static_cast<uint32_t>(-std::log(1.0 - unit(rng)) * mean);
+      heading = unit(rng) * 2 * kPi;
+    }
+    --left;
+
+    const BehaviorSpec s = spec(behavior);
+    if (s.speed_mps > 0.0) {
+      if (std::hypot(x, y) > 350.0) heading = std::atan2(-y, -x);
+      heading += jitter(rng) * 0.15;
+      x += std::cos(heading) * s.speed_mps;
+      y += std::sin(heading) * s.speed_mps;
+    }
+    const double activity =
+        std::max(0.0, s.activity_mg * (1.0 + 0.3 * jitter(rng)));
+
+    MotionSample m;
+    m.time_s = 1700000000u + t;
+    m.activity_mg = static_cast<uint16_t>(std::min(activity, 2000.0));
+    m.lat_e7 = home_lat + static_cast<int32_t>(std::lround(y * lat_per_m));
+    m.lon_e7 = home_lon + static_cast<int32_t>(std::lround(x * lon_per_m));
+    trace.push_back(m);
+  }
+  return trace;
+}
+
+bool load_motion_trace(const std::string& path,
+                       std::vector<MotionSample>* trace) {
+  FILE* f = std::fopen(path.c_str(), "r");
+  if (f == nullptr) return false;
+  trace->clear();
+  char line[256];
+  bool ok = true;
+  while (std::fgets(line, sizeof(line), f) != nullptr) {
+    if (line[0] == '#' || line[0] == '\n') continue;
+    unsigned long t = 0;
+    unsigned activity = 0;
+    long lat = 0;
+    long lon = 0;
+    if (std::sscanf(line, "%lu,%u,%ld,%ld", &t, &activity, &lat, &lon) != 4 ||
+        (!trace->empty() && t != trace->back().time_s + 1u)) {
+      ok = false;
+      break;
+    }
+    MotionSample m;
+    m.time_s = static_cast<uint32_t>(t);
+    m.activity_mg = static_cast<uint16_t>(activity);
+    m.lat_e7 = static_cast<int32_t>(lat);
+    m.lon_e7 = static_cast<int32_t>(lon);
+    trace->push_back(m);
+  }
+  std::fclose(f);
+  return ok && !trace->empty();
+}
+
+bool save_motion_trace(const std::string& path,
+                       const std::vector<MotionSample>& trace) {
+  FILE* f = std::fopen(path.c_str(), "w");
+  if (f == nullptr) return false;
+  std::fprintf(f, "# time_s,activity_mg,lat_e7,lon_e7\n");
+  for (const MotionSample& m : trace) {
+    std::fprintf(f, "%u,%u,%d,%d\n", m.time_s, m.activity_mg, m.lat_e7,
+                 m.lon_e7);
+  }
+  return std::fclose(f) == 0;
+}
+
+}  // namespace sim
+}  // namespace ct
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "track/fix.h"
+
+namespace ct {
+namespace sim {
+
+// One second of ground truth: accelerometer activity and true position.
+struct MotionSample {
+  uint32_t time_s = 0;
+  uint16_t activity_mg = 0;
+  int32_t lat_e7 = 0;
+  int32_t lon_e7 = 0;
+
+  track::Fix position() const {
+    track::Fix f;
+    f.time_s = time_s;
+    f.lat_e7 = lat_e7;
+    f.lon_e7 = lon_e7;
+    return f;
+  }
+};
+
+// 1 Hz trace of a cat's day: long naps, walks, sprints, and grooming bouts
+// that shake the accelerometer without going anywhere.
+std::vector<MotionSample> make_motion_trace(uint32_t seconds, uint32_t seed);
+
+// CSV with one "time_s,activity_mg,lat_e7,lon_e7" line per sample; lines
+// starting with '#' are comments. Samples must be one second apart.
+bool load_motion_trace(const std::string& path,
+                       std::vector<MotionSample>* trace);
+bool save_motion_trace(const std::string& path,
+                       const std::vector<MotionSample>& trace);
+
+}  // namespace sim
+}  // namespace ct
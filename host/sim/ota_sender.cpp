@@ -0,0 +1,132 @@
+#include "sim/ota_sender.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "common/crc32.h"
+
+namespace ct {
+namespace sim {
+
+FileImageSource::~FileImageSource() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
+Status FileImageSource::open(const std::string& path) {
+  fd_ = ::open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) return Status::kIoError;
+  struct stat st;
+  if (::fstat(fd_, &st) != 0) return Status::kIoError;
+  if (st.st_size > static_cast<off_t>(UINT32_MAX)) return Status::kNoSpace;
+  size_ = static_cast<uint32_t>(st.st_size);
+  return Status::kOk;
+}
+
+Status FileImageSource::read(uint32_t offset, uint8_t* dst, size_t len) {
+  if (offset > size_ || len > size_ - offset) return Status::kOutOfRange;
+  while (len > 0) {
+    const ssize_t n = ::pread(fd_, dst, len, offset);
+    if (n <= 0) return Status::kIoError;
+    dst += n;
+    offset += static_cast<uint32_t>(n);
+    len -= static_cast<size_t>(n);
+  }
+  return Status::kOk;
+}
+
+Status MemoryImageSource::read(uint32_t offset, uint8_t* dst, size_t len) {
+  if (offset > size_ || len > size_ - offset) return Status::kOutOfRange;
+  std::memcpy(dst, data_ + offset, len);
+  return Status::kOk;
+}
+
+Status describe_image(ImageSource* source, uint16_t chunk_size,
+                      uint32_t version, ota::ImageInfo* info) {
+  uint8_t buf[4096];
+  uint32_t crc = 0;
+  for (uint32_t off = 0; off < source->size(); off += sizeof(buf)) {
+    const uint32_t left = source->size() - off;
+    const uint32_t n = left < sizeof(buf) ? left : sizeof(buf);
+    CT_RETURN_IF_ERROR(source->read(off, buf, n));
+    crc = crc32_update(crc, buf, n);
+  }
+  info->kind = ota::ImageKind::kFull;
+  info->size = source->size();
+  info->crc32 = crc;
+  info->version = version;
+  info->chunk_size = chunk_size;
+  info->target_size = info->size;
+  info->target_crc32 = crc;
+  return Status::kOk;
+}
+
+Status OtaSender::request(const uint8_t* frame, size_t len, ota::Ack* ack) {
+  uint8_t reply[kMaxReplySize];
+  size_t reply_len = 0;
+  CT_RETURN_IF_ERROR(
+      link_->exchange(frame, len, reply, sizeof(reply), &reply_len));
+  return ota::decode_ack(reply, reply_len, ack);
+}
+
+Status OtaSender::run(uint32_t max_reconnects) {
+  uint8_t frame[ota::kMaxFrameSize];
+  uint8_t payload[ota::kMaxChunkSize];
+  const uint32_t chunks = info_.chunk_count();
+  uint32_t next = 0;
+  bool offered = false;
+
+  while (true) {
+    ota::Ack ack;
+    Status s;
+    if (!offered) {
+      s = request(frame, ota::encode_offer(info_, frame), &ack);
+    } else if (next < chunks) {
+      const uint16_t len = info_.chunk_len(next);
+      CT_RETURN_IF_ERROR(
+          source_->read(next * info_.chunk_size, payload, len));
+      s = request(frame, ota::encode_chunk(next, payload, len, frame), &ack);
+      ++stats_.chunks_sent;
+    } else {
+      s = request(frame, ota::encode_finish(frame), &ack);
+    }
+
+    if (s == Status::kDisconnected) {
+      if (++stats_.reconnects > max_reconnects) return Status::kDisconnected;
+      CT_RETURN_IF_ERROR(link_->reconnect());
+      offered = false;
+      continue;
+    }
+    CT_RETURN_IF_ERROR(s);
+
+    switch (ack.status) {
+      case Status::kOk:
+        if (!offered) {
+          offered = true;
+          if (ack.next_chunk > 0) ++stats_.resumes;
+        } else if (next >= chunks) {
+          return Status::kOk;
+        }
+        break;
+      case Status::kCrcMismatch:
+        // On Finish this means the slot failed verification and the device
+        // dropped the session; start over with a fresh offer.
+        if (offered && next >= chunks) offered = false;
+        ++stats_.retransmits;
+        break;
+      case Status::kCorrupt:
+      case Status::kOutOfRange:
+        // Damaged or out-of-sequence frame: resend what the device expects.
+        ++stats_.retransmits;
+        break;
+      default:
+        return ack.status;
+    }
+    next = ack.next_chunk;
+  }
+}
+
+}  // namespace sim
+}  // namespace ct
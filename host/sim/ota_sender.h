@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "ota/ota_protocol.h"
+#include "sim/transport.h"
+
+namespace ct {
+namespace sim {
+
+// Random-access view of an update image on the host. Images are read one
+// chunk at a time, never loaded whole.
+class ImageSource {
+ public:
+  virtual ~ImageSource() = default;
+  virtual uint32_t size() const = 0;
+  virtual Status read(uint32_t offset, uint8_t* dst, size_t len) = 0;
+};
+
+class FileImageSource : public ImageSource {
+ public:
+  FileImageSource() = default;
+  ~FileImageSource() override;
+  FileImageSource(const FileImageSource&) = delete;
+  FileImageSource& operator=(const FileImageSource&) = delete;
+
+  Status open(const std::string& path);
+
+  uint32_t size() const override { return size_; }
+  Status read(uint32_t offset, uint8_t* dst, size_t len) override;
+
+ private:
+  int fd_ = -1;
+  uint32_t size_ = 0;
+};
+
+// Image already in host memory, e.g. a generated patch.
+class MemoryImageSource : public ImageSource {
+ public:
+  MemoryImageSource(const uint8_t* data, uint32_t size)
+      : data_(data), size_(size) {}
+
+  uint32_t size() const override { return size_; }
+  Status read(uint32_t offset, uint8_t* dst, size_t len) override;
+
+ private:
+  const uint8_t* data_;
+  uint32_t size_;
+};
+
+// Fills |info| for a full-image update from |source|, computing the image
+// CRC in one streaming pass.
+Status describe_image(ImageSource* source, uint16_t chunk_size,
+                      uint32_t version, ota::ImageInfo* info);
+
+struct SenderStats {
+  uint64_t chunks_sent = 0;
+  uint64_t retransmits = 0;
+  uint64_t resumes = 0;
+  uint64_t reconnects = 0;
+};
+
+// Host side of an OTA session: offers the image, streams chunks from wherever
+// the device says it needs them, and re-offers after every reconnect so the
+// device can report its resume point.
+class OtaSender {
+ public:
+  OtaSender(Transport* link, ImageSource* source, const ota::ImageInfo& info)
+      : link_(link), source_(source), info_(info) {}
+
+  // Runs the session to a verified image. Gives up with kDisconnected after
+  // |max_reconnects| link losses.
+  Status run(uint32_t max_reconnects);
+
+  const SenderStats& stats() const { return stats_; }
+
+ private:
+  Status request(const uint8_t* frame, size_t len, ota::Ack* ack);
+
+  Transport* link_;
+  ImageSource* source_;
+  ota::ImageInfo info_;
+  SenderStats stats_;
+};
+
+}  // namespace sim
+}  // namespace ct
@@ -0,0 +1,98 @@
+#include "sim/synthetic_image.h"
+
+#include <random>
+
+#include "common/byte_io.h"
+
+namespace ct {
+namespace sim {
+namespace {
+
+constexpr uint32_t kVocabulary = 2048;
+
+class WordGen {
+ public:
+  explicit WordGen(uint32_t seed) : rng_(seed), vocab_(kVocabulary) {
+    // Keep instruction words out of the pointer range so relinking can tell
+    // them apart.
+    for (auto& w : vocab_) w = (rng_() & 0xF0FFFFFFu) | 0x40000000u;
+  }
+
+  uint32_t instruction() { return vocab_[rng_() % kVocabulary]; }
+
+  uint32_t word(uint32_t image_words) {
+    const uint32_t roll = rng_() % 100;
+    if (roll < 8) return kImageLinkBase + 4 * (rng_() % image_words);
+    if (roll < 12) return rng_() & 0x0000FFFFu;
+    return instruction();
+  }
+
+  std::mt19937& rng() { return rng_; }
+
+ private:
+  std::mt19937 rng_;
+  std::vector<uint32_t> vocab_;
+};
+
+bool is_pointer(uint32_t w, uint32_t image_size) {
+  return w >= kImageLinkBase && w < kImageLinkBase + image_size;
+}
+
+}  // namespace
+
+std::vector<uint8_t> make_firmware(uint32_t size, uint32_t seed) {
+  WordGen gen(seed);
+  const uint32_t words = size / 4;
+  std::vector<uint8_t> image(size, 0xFF);
+  for (uint32_t i = 0; i < words; ++i) put_u32(&image[4 * i], gen.word(words));
+  return image;
+}
+
+std::vector<uint8_t> next_release(const std::vector<uint8_t>& base,
+                                  uint32_t seed) {
+  WordGen gen(seed);
+  const uint32_t size = static_cast<uint32_t>(base.size()) & ~3u;
+  const uint32_t insert_at = (size * 35 / 100) & ~3u;
+  const uint32_t insert_len = (size / 64) & ~3u;
+  const uint32_t remove_at = (size * 70 / 100) & ~3u;
+  const uint32_t remove_len = (size / 128) & ~3u;
+  const uint32_t new_size = size + insert_len - remove_len;
+
+  auto relink = [&](uint32_t addr) {
+    uint32_t off = addr - kImageLinkBase;
+    if (off >= remove_at + remove_len) {
+      off -= remove_len;
+    } else if (off >= remove_at) {
+      off = remove_at;
+    }
+    if (off >= insert_at) off += insert_len;
+    return kImageLinkBase + off;
+  };
+
+  std::vector<uint8_t> out;
+  out.reserve(new_size);
+  uint8_t w[4];
+  for (uint32_t off = 0; off < size; off += 4) {
+    if (off == insert_at) {
+      for (uint32_t i = 0; i < insert_len; i += 4) {
+        put_u32(w, gen.word(new_size / 4));
+        out.insert(out.end(), w, w + 4);
+      }
+    }
+    if (off >= remove_at && off < remove_at + remove_len) continue;
+    uint32_t v = get_u32(&base[off]);
+    if (is_pointer(v, size)) v = relink(v);
+    put_u32(w, v);
+    out.insert(out.end(), w, w + 4);
+  }
+
+  const uint32_t patched = new_size / 2048 + 1;
+  for (uint32_t i = 0; i < patched; ++i) {
+    const uint32_t at = 4 * (gen.rng()() % (new_size / 4));
+    put_u32(&out[at], gen.instruction());
+  }
+  return out;
+}
+
+}  // namespace sim
+}  // namespace ct
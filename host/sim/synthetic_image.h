@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ct {
+namespace sim {
+
+// Load address the synthetic images are "linked" at.
+constexpr uint32_t kImageLinkBase = 0x08000000;
+
+// Firmware-like test image: 32-bit words drawn from a small instruction
+// vocabulary, with absolute pointers into the image and literal constants
+// mixed in. Unlike random bytes it has the redundancy real code has.
+std::vector<uint8_t> make_firmware(uint32_t size, uint32_t seed);
+
+// Derives the next release from |base| the way a rebuild does: a function is
+// inserted and another removed, every pointer past the edits is relinked, and
+// a few scattered words change. Most of the image survives only shifted.
+std::vector<uint8_t> next_release(const std::vector<uint8_t>& base,
+                                  uint32_t seed);
+
+}  // namespace sim
+}  // namespace ct
@@ -0,0 +1,68 @@
+#include "sim/synthetic_track.h"
+
+#include <cmath>
+#include <random>
+
+#include "track/geo.h"
+
+namespace ct {
+namespace sim {
+
+std::vector<track::Fix> make_cat_track(uint32_t count, uint32_t seed,
+                                       const TrackModel& model) {
+  constexpr double kPi = 3.14159265358979323846;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::normal_distribution<double> noise(0.0, model.gps_noise_m);
+
+  const double lat_scale = 1e7 / track::kMetersPerDegree;
+  const double lon_scale = 1.0 / track::lon_scale_m(model.home_lat_e7);
+
+  std::vector<track::Fix> out;
+  out.reserve(count);
+  double x = 0.0;  // meters east of home
+  double y = 0.0;  // meters north of home
+  double heading = 0.0;
+  double speed = 0.0;
+  uint32_t t = model.start_time_s;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const double roll = unit(rng);
+    if (speed == 0.0 ? roll < 0.05 : roll < 0.1) {
+      // Switch between resting, walking and the occasional sprint.
+      const double mode = unit(rng);
+      if (mode < 0.4) {
+        speed = 0.0;
+      } else if (mode < 0.95) {
+        speed = 0.3 + unit(rng);
+      } else {
+        speed = 3.0 + 3.0 * unit(rng);
+      }
+      heading = unit(rng) * 2 * kPi;
+    }
+    if (std::hypot(x, y) > model.roam_radius_m) heading = std::atan2(-y, -x);
+    heading += (unit(rng) - 0.5) * 0.6;
+
+    uint32_t dt = model.interval_s;
+    if (unit(rng) < model.gap_chance) {
+      dt += static_cast<uint32_t>(unit(rng) * model.max_gap_s);
+    }
+    x += std::cos(heading) * speed * dt;
+    y += std::sin(heading) * speed * dt;
+    t += dt;
+
+    track::Fix fix;
+    fix.time_s = t;
+    const double north = y + noise(rng);
+    const double east = x + noise(rng);
+    fix.lat_e7 = model.home_lat_e7 +
+                 static_cast<int32_t>(std::lround(north * lat_scale));
+    fix.lon_e7 = model.home_lon_e7 +
+                 static_cast<int32_t>(std::lround(east * lon_scale));
+    out.push_back(fix);
+  }
+  return out;
+}
+
+}  // namespace sim
+}  // namespace ct
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "track/fix.h"
+
+namespace ct {
+namespace sim {
+
+struct TrackModel {
+  uint32_t start_time_s = 1700000000;
+  uint32_t interval_s = 30;
+  int32_t home_lat_e7 = 473769000;  // Zurich
+  int32_t home_lon_e7 = 85417000;
+  double roam_radius_m = 400.0;
+  double gps_noise_m = 3.0;
+  // Chance that a fix follows an indoor spell without one, lasting up to
+  // max_gap_s. Per fix, so fast rates see gaps more often per hour.
+  double gap_chance = 0.01;
+  uint32_t max_gap_s = 3600;
+};
+
+// Synthetic cat: long rests near home, bursts of walking and the odd sprint,
+// a leash back towards home, receiver noise, and occasional gaps when the
+// cat is indoors without a fix.
+std::vector<track::Fix> make_cat_track(uint32_t count, uint32_t seed,
+                                       const TrackModel& model = TrackModel());
+
+}  // namespace sim
+}  // namespace ct
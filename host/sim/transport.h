@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "common/status.h"
+
+namespace ct {
+namespace sim {
+
+constexpr size_t kMaxReplySize = 64;
+
+// Device-side endpoint of a link: consumes one request frame and writes the
+// reply (at most kMaxReplySize bytes) into |reply|, returning its length.
+using FrameHandler =
+    std::function<size_t(const uint8_t* frame, size_t len, uint8_t* reply)>;
+
+struct LinkStats {
+  uint64_t frames = 0;
+  uint64_t bytes_up = 0;    // host -> device
+  uint64_t bytes_down = 0;  // device -> host
+  uint64_t drops = 0;
+  uint64_t corruptions = 0;
+  uint64_t reconnects = 0;
+  double airtime_us = 0.0;
+};
+
+// Request/response datagram link as seen from the host.
+class Transport {
+ public:
+  virtual ~Transport() = default;
+
+  // Sends |frame| and waits for the reply. kDisconnected means the link went
+  // down; the frame may or may not have reached the device.
+  virtual Status exchange(const uint8_t* frame, size_t len, uint8_t* reply,
+                          size_t reply_cap, size_t* reply_len) = 0;
+  virtual Status reconnect() = 0;
+
+  virtual const LinkStats& stats() const = 0;
+};
+
+}  // namespace sim
+}  // namespace ct
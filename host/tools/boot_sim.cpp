@@ -0,0 +1,471 @@
+// Runs an A/B update from download to confirmed boot, cutting power at every
+// flash write step along the way.
+//
+//   boot_sim [--image_kib=N] [--chunk=BYTES] [--delta]
+//            [--new_image=good|unhealthy|crash] [--attempts=N] [--stride=N]
+//            [--boot_ms=MS] [--health_s=S] [--watchdog_s=S] [--seed=N]
+//            [--workdir=DIR]
+//
+// A first pass runs undisturbed and counts the flash writes (programs and
+// erases) of the whole update, boot records included. Then, for each write
+// step k, the update is replayed on a fresh device whose power dies in the
+// middle of write k; the device reboots and carries on. Every boot checks
+// that the slot the bootloader picked holds exactly the image its record
+// describes, and every run must end with the new image confirmed, or, for a
+// failing image, rolled back to the old one. After the undisturbed run the
+// same image is offered once more, as a server does when the confirm report
+// is lost; the device must answer that it is installed and keep the old
+// image in the other slot for rollback. A receiver pointed at that slot
+// anyway must not take the finished journal for its own.
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/byte_io.h"
+#include "common/crc32.h"
+#include "delta/delta_encoder.h"
+#include "ota/boot_manager.h"
+#include "ota/ota_receiver.h"
+#include "sim/faulty_transport.h"
+#include "sim/file_flash.h"
+#include "sim/flags.h"
+#include "sim/synthetic_image.h"
+
+using namespace ct;
+
+namespace {
+
+constexpr uint32_t kSectorSize = 4096;
+constexpr uint32_t kOtaStateSize = 2 * kSectorSize;
+constexpr uint32_t kBootStateSize = 2 * kSectorSize;
+// Far more boots than any correct run needs; hitting it is a boot loop.
+constexpr uint32_t kMaxBoots = 64;
+
+enum class Health { kGood, kUnhealthy, kCrash };
+
+enum class Outcome { kPowerCut, kConfirmed, kRolledBack, kBricked, kError };
+
+const char* outcome_name(Outcome o) {
+  switch (o) {
+    case Outcome::kPowerCut: return "power_cut";
+    case Outcome::kConfirmed: return "confirmed";
+    case Outcome::kRolledBack: return "rolled_back";
+    case Outcome::kBricked: return "bricked";
+    case Outcome::kError: return "error";
+  }
+  return "?";
+}
+
+struct Scenario {
+  std::string flash_path;
+  std::vector<uint8_t> old_image;
+  std::vector<uint8_t> new_image;
+  std::vector<uint8_t> payload;  // new image or patch
+  ota::ImageInfo info;
+  Health health = Health::kGood;
+  ota::BootPolicy policy;
+  uint32_t slot_size = 0;
+  double boot_s = 0.25;
+  double health_s = 30.0;
+  double watchdog_s = 10.0;  // time for a crashing image to be reset
+};
+
+struct Device {
+  sim::FileFlash flash;
+  sim::FileFlash probe;  // harness-only view, outside the flash stats
+  Partition slots[ota::BootManager::kSlotCount];
+  Partition ota_state;
+  Partition boot_state;
+};
+
+struct Tally {
+  uint32_t boots = 0;
+  uint32_t transfers = 0;
+  uint32_t resumed = 0;  // transfers that did not start at chunk zero
+  double link_s = 0.0;
+  double boot_s = 0.0;
+  double health_s = 0.0;
+  Status error = Status::kOk;
+};
+
+bool slot_equals(const Partition& slot, const std::vector<uint8_t>& image) {
+  std::vector<uint8_t> buf(image.size());
+  return is_ok(slot.read(0, buf.data(), buf.size())) && buf == image;
+}
+
+// What the bootloader is about to run must be a complete image matching its
+// boot record.
+bool boot_target_intact(Device* dev, uint8_t slot,
+                        const ota::SlotInfo& info) {
+  if (info.state != ota::SlotState::kGood &&
+      info.state != ota::SlotState::kPending) {
+    return false;
+  }
+  const Partition view(&dev->probe, dev->slots[slot].offset(),
+                       dev->slots[slot].size());
+  std::vector<uint8_t> buf(info.size);
+  return info.size <= view.size() &&
+         is_ok(view.read(0, buf.data(), buf.size())) &&
+         crc32(buf.data(), buf.size()) == info.crc32;
+}
+
+// Device end of an OTA session. The offer is compared with the confirmed
+// image before anything is erased: an image that is already installed is
+// acknowledged with no chunks left to send, leaving the other slot and the
+// rollback image in it alone. Any other offer claims the update slot and
+// hands the session to an OtaReceiver.
+class DeviceSession {
+ public:
+  DeviceSession(Device* dev, ota::BootManager* boot) : dev_(dev), boot_(boot) {}
+
+  size_t handle_frame(const uint8_t* frame, size_t len, uint8_t* reply) {
+    if (receiver_) return receiver_->handle_frame(frame, len, reply);
+    ota::Ack ack;
+    if (!installed_) {
+      ota::ImageInfo offer;
+      ack.status = ota::decode_offer(frame, len, &offer);
+      if (is_ok(ack.status) &&
+          boot_->installed(offer.target_size, offer.target_crc32)) {
+        installed_ = true;
+        chunks_ = offer.chunk_count();
+      } else if (is_ok(ack.status)) {
+        ack.status = boot_->begin_update(&target_);
+        if (is_ok(ack.status)) {
+          receiver_ = std::make_unique<ota::OtaReceiver>(
+              dev_->slots[target_], dev_->slots[boot_->confirmed_slot()],
+              dev_->ota_state);
+          return receiver_->handle_frame(frame, len, reply);
+        }
+      }
+    }
+    ack.next_chunk = chunks_;
+    return ota::encode_ack(ack, reply);
+  }
+
+  bool installed() const { return installed_; }
+  bool verified() const { return receiver_ && receiver_->verified(); }
+  uint8_t target() const { return target_; }
+
+ private:
+  Device* dev_;
+  ota::BootManager* boot_;
+  std::unique_ptr<ota::OtaReceiver> receiver_;
+  uint8_t target_ = 0;
+  bool installed_ = false;
+  uint32_t chunks_ = 0;
+};
+
+// Host side of the transfer: offers the image, sends chunks from the
+// device's resume point and finishes. Stops as soon as the device dies.
+Status transfer(const Scenario& sc, sim::Transport* link,
+                const sim::FileFlash& flash, uint32_t* first_chunk) {
+  uint8_t frame[ota::kMaxFrameSize];
+  uint8_t reply[sim::kMaxReplySize];
+  ota::Ack ack;
+  auto request = [&](size_t len) {
+    size_t reply_len = 0;
+    CT_RETURN_IF_ERROR(
+        link->exchange(frame, len, reply, sizeof(reply), &reply_len));
+    if (!flash.powered()) return Status::kIoError;
+    CT_RETURN_IF_ERROR(ota::decode_ack(reply, reply_len, &ack));
+    return ack.status;
+  };
+  CT_RETURN_IF_ERROR(request(ota::encode_offer(sc.info, frame)));
+  *first_chunk = ack.next_chunk;
+  for (uint32_t i = ack.next_chunk; i < sc.info.chunk_count(); ++i) {
+    CT_RETURN_IF_ERROR(request(ota::encode_chunk(
+        i, sc.payload.data() + i * sc.info.chunk_size,
+        static_cast<uint16_t>(sc.info.chunk_len(i)), frame)));
+  }
+  return request(ota::encode_finish(frame));
+}
+
+// Boots the device over and over until the update settles or power dies.
+Outcome run_device(const Scenario& sc, Device* dev, Tally* t) {
+  while (t->boots < kMaxBoots) {
+    ++t->boots;
+    ota::BootManager boot(dev->boot_state, sc.policy);
+    uint8_t slot = 0;
+    Status st = boot.mount();
+    if (is_ok(st)) st = boot.select_boot(&slot);
+    if (!dev->flash.powered()) return Outcome::kPowerCut;
+    if (!is_ok(st)) {
+      t->error = st;
+      return Outcome::kBricked;
+    }
+    t->boot_s += sc.boot_s;
+    if (!boot_target_intact(dev, slot, boot.slot(slot))) {
+      return Outcome::kBricked;
+    }
+
+    if (slot == boot.pending_slot()) {
+      // Running the new image on trial.
+      if (sc.health == Health::kCrash) {
+        t->health_s += sc.watchdog_s;
+        continue;
+      }
+      t->health_s += sc.health_s;
+      st = sc.health == Health::kGood ? boot.confirm() : boot.reject();
+      if (!dev->flash.powered()) return Outcome::kPowerCut;
+      if (!is_ok(st)) {
+        t->error = st;
+        return Outcome::kError;
+      }
+      if (sc.health == Health::kGood) return Outcome::kConfirmed;
+      continue;
+    }
+
+    // Running the confirmed image: done, or fetch the update.
+    if (boot.slot(slot).crc32 == sc.info.target_crc32) {
+      return Outcome::kConfirmed;
+    }
+    if (boot.slot(slot ^ 1).state == ota::SlotState::kBad) {
+      return Outcome::kRolledBack;
+    }
+    DeviceSession session(dev, &boot);
+    sim::FaultyTransport link(
+        [&session](const uint8_t* frame, size_t len, uint8_t* reply) {
+          return session.handle_frame(frame, len, reply);
+        },
+        sim::FaultConfig());
+    uint32_t first_chunk = 0;
+    st = transfer(sc, &link, dev->flash, &first_chunk);
+    ++t->transfers;
+    if (first_chunk > 0) ++t->resumed;
+    t->link_s += link.stats().airtime_us / 1e6;
+    if (is_ok(st) && !session.verified()) st = Status::kBadState;
+    if (is_ok(st)) {
+      st = boot.stage(session.target(), sc.info.target_size,
+                      sc.info.target_crc32, sc.info.version);
+    }
+    if (!dev->flash.powered()) return Outcome::kPowerCut;
+    if (!is_ok(st)) {
+      t->error = st;
+      return Outcome::kError;
+    }
+  }
+  return Outcome::kError;
+}
+
+// Offers the image again to a device that already runs it confirmed. True
+// when the device answers that it is installed, the other slot still holds
+// the old image and its record, and a receiver for that slot starts afresh
+// rather than resuming the finished journal of the confirmed one.
+bool reoffer_safe(const Scenario& sc, Device* dev, uint32_t* first_chunk) {
+  ota::BootManager boot(dev->boot_state, sc.policy);
+  if (!is_ok(boot.mount())) return false;
+  const uint8_t rollback = boot.confirmed_slot() ^ 1;
+  const ota::SlotInfo before = boot.slot(rollback);
+  DeviceSession session(dev, &boot);
+  sim::FaultyTransport link(
+      [&session](const uint8_t* frame, size_t len, uint8_t* reply) {
+        return session.handle_frame(frame, len, reply);
+      },
+      sim::FaultConfig());
+  if (!is_ok(transfer(sc, &link, dev->flash, first_chunk)) ||
+      !session.installed()) {
+    return false;
+  }
+
+  ota::BootManager check(dev->boot_state, sc.policy);
+  if (!is_ok(check.mount()) || check.slot(rollback).state != before.state ||
+      check.slot(rollback).crc32 != before.crc32 ||
+      !slot_equals(dev->slots[rollback], sc.old_image)) {
+    return false;
+  }
+  // The old image doubles as the base, so a delta offer passes its check.
+  ota::OtaReceiver stray(dev->slots[rollback], dev->slots[rollback],
+                         dev->ota_state);
+  return is_ok(stray.begin(sc.info)) && stray.next_chunk() == 0;
+}
+
+struct Trial {
+  Outcome outcome = Outcome::kError;
+  Tally tally;
+  sim::FlashStats flash;
+  bool image_ok = false;  // confirmed slot holds the expected image
+  double total_s = 0.0;   // update start to confirmed (or rolled back)
+  bool reoffer_ok = true;
+  uint32_t reoffer_chunk = 0;  // resume point the repeated offer got
+};
+
+Trial run_trial(const Scenario& sc, uint64_t cut_at, uint32_t seed,
+                bool reoffer = false) {
+  Trial r;
+  Device dev;
+  const uint32_t size = 2 * sc.slot_size + kOtaStateSize + kBootStateSize;
+  if (!is_ok(dev.flash.open(sc.flash_path, size, kSectorSize, true)) ||
+      !is_ok(dev.probe.open(sc.flash_path, size, kSectorSize, false))) {
+    return r;
+  }
+  dev.slots[0] = Partition(&dev.flash, 0, sc.slot_size);
+  dev.slots[1] = Partition(&dev.flash, sc.slot_size, sc.slot_size);
+  dev.ota_state = Partition(&dev.flash, 2 * sc.slot_size, kOtaStateSize);
+  dev.boot_state = Partition(&dev.flash, 2 * sc.slot_size + kOtaStateSize,
+                             kBootStateSize);
+
+  // Factory state: the old image in slot A, confirmed.
+  ota::BootManager factory(dev.boot_state, sc.policy);
+  const std::vector<uint8_t>& old_image = sc.old_image;
+  if (!is_ok(dev.slots[0].program(0, old_image.data(), old_image.size())) ||
+      !is_ok(factory.format(0, static_cast<uint32_t>(old_image.size()),
+                            crc32(old_image.data(), old_image.size()), 1))) {
+    return r;
+  }
+  dev.flash.reset_stats();
+
+  if (cut_at > 0) dev.flash.cut_power_after(cut_at, seed);
+  r.outcome = run_device(sc, &dev, &r.tally);
+  if (r.outcome == Outcome::kPowerCut) {
+    dev.flash.restore_power();
+    r.outcome = run_device(sc, &dev, &r.tally);
+  }
+  r.flash = dev.flash.stats();
+
+  ota::BootManager check(dev.boot_state, sc.policy);
+  if (is_ok(check.mount())) {
+    const Partition confirmed = dev.slots[check.confirmed_slot()];
+    r.image_ok = slot_equals(confirmed, r.outcome == Outcome::kConfirmed
+                                            ? sc.new_image
+                                            : sc.old_image);
+  }
+  r.total_s = r.tally.link_s + r.flash.modeled_us / 1e6 + r.tally.boot_s +
+              r.tally.health_s;
+  if (reoffer && r.outcome == Outcome::kConfirmed) {
+    r.reoffer_ok = reoffer_safe(sc, &dev, &r.reoffer_chunk);
+  }
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sim::Flags flags(argc, argv);
+  const uint32_t seed = static_cast<uint32_t>(flags.get_u64("seed", 1));
+  const uint32_t size =
+      static_cast<uint32_t>(flags.get_u64("image_kib", 128) * 1024);
+  const uint64_t stride = std::max<uint64_t>(1, flags.get_u64("stride", 1));
+  const std::string health = flags.get("new_image", "good");
+
+  Scenario sc;
+  sc.flash_path = flags.get("workdir", "/tmp") + "/boot_sim_flash.bin";
+  sc.policy.max_attempts =
+      static_cast<uint8_t>(flags.get_u64("attempts", 3));
+  sc.boot_s = flags.get_double("boot_ms", 250.0) / 1e3;
+  sc.health_s = flags.get_double("health_s", 30.0);
+  sc.watchdog_s = flags.get_double("watchdog_s", 10.0);
+  if (health == "good") {
+    sc.health = Health::kGood;
+  } else if (health == "unhealthy") {
+    sc.health = Health::kUnhealthy;
+  } else if (health == "crash") {
+    sc.health = Health::kCrash;
+  } else {
+    std::fprintf(stderr, "unknown --new_image=%s\n", health.c_str());
+    return 1;
+  }
+  const Outcome expected =
+      sc.health == Health::kGood ? Outcome::kConfirmed : Outcome::kRolledBack;
+
+  sc.old_image = sim::make_firmware(size, seed);
+  sc.new_image = sim::next_release(sc.old_image, seed + 1);
+  sc.slot_size = align_up(static_cast<uint32_t>(std::max(
+                              sc.old_image.size(), sc.new_image.size())),
+                          kSectorSize);
+  ota::ImageInfo& info = sc.info;
+  info.kind = ota::ImageKind::kFull;
+  info.target_size = static_cast<uint32_t>(sc.new_image.size());
+  info.target_crc32 = crc32(sc.new_image.data(), sc.new_image.size());
+  info.version = 2;
+  info.chunk_size = static_cast<uint16_t>(flags.get_u64("chunk", 512));
+  if (flags.has("delta")) {
+    delta::PatchStats patch_stats;
+    sc.payload = delta::encode_delta(sc.old_image, sc.new_image,
+                                     delta::EncoderOptions(), &patch_stats);
+    info.kind = ota::ImageKind::kDelta;
+    info.base_size = static_cast<uint32_t>(sc.old_image.size());
+    info.base_crc32 = crc32(sc.old_image.data(), sc.old_image.size());
+  } else {
+    sc.payload = sc.new_image;
+  }
+  info.size = static_cast<uint32_t>(sc.payload.size());
+  info.crc32 = crc32(sc.payload.data(), sc.payload.size());
+
+  std::printf("image %zu bytes, %s payload %zu bytes in %u chunks; new image "
+              "%s, %u boot attempts\n",
+              sc.new_image.size(),
+              info.kind == ota::ImageKind::kDelta ? "delta" : "full",
+              sc.payload.size(), info.chunk_count(), health.c_str(),
+              sc.policy.max_attempts);
+
+  const Trial clean = run_trial(sc, 0, seed, true);
+  const uint64_t steps = clean.flash.program_ops + clean.flash.sectors_erased;
+  std::printf("\nuninterrupted: %s, %llu write steps (%llu programs, %llu "
+              "erases), %u boots\n",
+              outcome_name(clean.outcome),
+              static_cast<unsigned long long>(steps),
+              static_cast<unsigned long long>(clean.flash.program_ops),
+              static_cast<unsigned long long>(clean.flash.sectors_erased),
+              clean.tally.boots);
+  std::printf("  link %.2f s + flash %.2f s + boots %.2f s + health %.2f s"
+              " = %.2f s to %s\n",
+              clean.tally.link_s, clean.flash.modeled_us / 1e6,
+              clean.tally.boot_s, clean.tally.health_s, clean.total_s,
+              sc.health == Health::kGood ? "confirmed" : "rollback");
+  std::printf("  flash read: %llu bytes (the new image is verified as it is "
+              "written, never read back)\n",
+              static_cast<unsigned long long>(clean.flash.bytes_read));
+  if (clean.outcome == Outcome::kConfirmed) {
+    std::printf("  same image offered again after confirm: resume point %u "
+                "of %u, %s\n",
+                clean.reoffer_chunk, info.chunk_count(),
+                clean.reoffer_ok ? "installed, rollback slot kept, ok"
+                                 : "FAILED");
+  }
+  bool ok = clean.outcome == expected && clean.image_ok && clean.reoffer_ok;
+
+  uint64_t trials = 0;
+  uint64_t failures = 0;
+  uint64_t resumed = 0;
+  double sum_s = 0.0;
+  double max_s = 0.0;
+  uint64_t max_at = 0;
+  for (uint64_t k = 1; k <= steps; k += stride) {
+    const Trial t = run_trial(sc, k, seed * 7919u + static_cast<uint32_t>(k));
+    ++trials;
+    resumed += t.tally.resumed;
+    sum_s += t.total_s;
+    if (t.total_s > max_s) {
+      max_s = t.total_s;
+      max_at = k;
+    }
+    if (t.outcome != expected || !t.image_ok) {
+      ++failures;
+      if (failures <= 10) {
+        std::printf("  cut at step %llu: %s (%s)%s\n",
+                    static_cast<unsigned long long>(k),
+                    outcome_name(t.outcome), status_name(t.tally.error),
+                    t.image_ok ? "" : ", wrong image");
+      }
+    }
+  }
+  ok = ok && failures == 0;
+  std::printf("\npower cut at %llu of %llu write steps: %llu ok, %llu "
+              "failed, %llu transfers resumed mid-image\n",
+              static_cast<unsigned long long>(trials),
+              static_cast<unsigned long long>(steps),
+              static_cast<unsigned long long>(trials - failures),
+              static_cast<unsigned long long>(failures),
+              static_cast<unsigned long long>(resumed));
+  if (trials > 0) {
+    std::printf("  update-to-%s with one power cut: mean %.2f s, worst "
+                "%.2f s (cut at step %llu)\n",
+                sc.health == Health::kGood ? "confirmed" : "rollback",
+                sum_s / trials, max_s, static_cast<unsigned long long>(max_at));
+  }
+  std::printf("result: %s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+// Compares a delta OTA update against a full-image update of the same
+// release, both run end to end against file-backed flash.
+//
+//   delta_bench [--image_kib=N] [--chunk=BYTES] [--drop=P] [--corrupt=P]
+//               [--reboot] [--seed=N] [--workdir=DIR]
+//
+// Device RAM is static: the receiver (including the patch decoder) plus one
+// frame buffer, and it is the same for both modes.
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/byte_io.h"
+#include "common/crc32.h"
+#include "delta/delta_encoder.h"
+#include "ota/ota_receiver.h"
+#include "sim/faulty_transport.h"
+#include "sim/file_flash.h"
+#include "sim/flags.h"
+#include "sim/ota_sender.h"
+#include "sim/synthetic_image.h"
+
+using namespace ct;
+
+namespace {
+
+constexpr uint32_t kSectorSize = 4096;
+constexpr uint32_t kStateSize = 2 * kSectorSize;
+
+struct RunResult {
+  Status status = Status::kOk;
+  bool match = false;
+  uint64_t link_bytes = 0;
+  double airtime_s = 0.0;
+  uint64_t flash_programmed = 0;
+  uint64_t flash_read = 0;
+  uint64_t flash_erases = 0;
+  double flash_s = 0.0;
+  double wall_s = 0.0;
+};
+
+struct Setup {
+  std::string workdir;
+  uint16_t chunk = 512;
+  sim::FaultConfig fault;
+  bool reboot = false;
+};
+
+RunResult run_update(const Setup& setup, const std::vector<uint8_t>& running,
+                     const std::vector<uint8_t>& release,
+                     const std::vector<uint8_t>& payload,
+                     const ota::ImageInfo& info) {
+  RunResult r;
+  const uint32_t slot_size = align_up(
+      static_cast<uint32_t>(std::max(running.size(), release.size())),
+      kSectorSize);
+  sim::FileFlash flash;
+  r.status = flash.open(setup.workdir + "/delta_bench_flash.bin",
+                        2 * slot_size + kStateSize, kSectorSize, true);
+  if (!is_ok(r.status)) return r;
+  const Partition slot_a(&flash, 0, slot_size);
+  const Partition slot_b(&flash, slot_size, slot_size);
+  const Partition state(&flash, 2 * slot_size, kStateSize);
+  r.status = slot_a.program(0, running.data(), running.size());
+  if (!is_ok(r.status)) return r;
+  flash.reset_stats();
+
+  auto receiver = std::make_unique<ota::OtaReceiver>(slot_b, slot_a, state);
+  sim::FaultyTransport link(
+      [&receiver](const uint8_t* frame, size_t len, uint8_t* reply) {
+        return receiver->handle_frame(frame, len, reply);
+      },
+      setup.fault);
+  if (setup.reboot) {
+    link.set_on_reconnect([&] {
+      receiver = std::make_unique<ota::OtaReceiver>(slot_b, slot_a, state);
+    });
+  }
+  sim::MemoryImageSource source(payload.data(),
+                                static_cast<uint32_t>(payload.size()));
+  sim::OtaSender sender(&link, &source, info);
+
+  const auto t0 = std::chrono::steady_clock::now();
+  r.status = sender.run(100000);
+  r.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           t0)
+                 .count();
+
+  std::vector<uint8_t> check(release.size());
+  r.match = is_ok(r.status) && receiver->verified() &&
+            is_ok(slot_b.read(0, check.data(), check.size())) &&
+            check == release;
+  r.link_bytes = link.stats().bytes_up + link.stats().bytes_down;
+  r.airtime_s = link.stats().airtime_us / 1e6;
+  r.flash_programmed = flash.stats().bytes_programmed;
+  r.flash_read = flash.stats().bytes_read;
+  r.flash_erases = flash.stats().sectors_erased;
+  r.flash_s = flash.stats().modeled_us / 1e6;
+  return r;
+}
+
+void print_row(const char* name, uint32_t payload, const RunResult& r) {
+  std::printf(
+      "%-6s %10u %10llu %9.2f %10llu %10llu %7llu %9.2f %9.2f %8.4f %s\n",
+      name, payload, static_cast<unsigned long long>(r.link_bytes),
+      r.airtime_s, static_cast<unsigned long long>(r.flash_programmed),
+      static_cast<unsigned long long>(r.flash_read),
+      static_cast<unsigned long long>(r.flash_erases), r.flash_s,
+      r.airtime_s + r.flash_s, r.wall_s,
+      r.match ? "ok" : status_name(r.status));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sim::Flags flags(argc, argv);
+  Setup setup;
+  setup.workdir = flags.get("workdir", "/tmp");
+  setup.chunk = static_cast<uint16_t>(flags.get_u64("chunk", 512));
+  setup.fault.drop_rate = flags.get_double("drop", 0.0);
+  setup.fault.corrupt_rate = flags.get_double("corrupt", 0.0);
+  setup.fault.seed = static_cast<uint32_t>(flags.get_u64("seed", 1));
+  setup.reboot = flags.has("reboot");
+  const uint32_t size =
+      static_cast<uint32_t>(flags.get_u64("image_kib", 512) * 1024);
+
+  const std::vector<uint8_t> v1 = sim::make_firmware(size, setup.fault.seed);
+  const std::vector<uint8_t> v2 = sim::next_release(v1, setup.fault.seed + 1);
+
+  delta::PatchStats stats;
+  const auto t0 = std::chrono::steady_clock::now();
+  const std::vector<uint8_t> patch =
+      delta::encode_delta(v1, v2, delta::EncoderOptions(), &stats);
+  const double encode_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+          .count();
+
+  ota::ImageInfo full;
+  full.kind = ota::ImageKind::kFull;
+  full.size = full.target_size = static_cast<uint32_t>(v2.size());
+  full.crc32 = full.target_crc32 = crc32(v2.data(), v2.size());
+  full.version = 2;
+  full.chunk_size = setup.chunk;
+
+  ota::ImageInfo diff = full;
+  diff.kind = ota::ImageKind::kDelta;
+  diff.size = static_cast<uint32_t>(patch.size());
+  diff.crc32 = crc32(patch.data(), patch.size());
+  diff.base_size = static_cast<uint32_t>(v1.size());
+  diff.base_crc32 = crc32(v1.data(), v1.size());
+
+  std::printf("base %zu bytes, target %zu bytes, patch %zu bytes (%.2f%%)\n",
+              v1.size(), v2.size(), patch.size(),
+              100.0 * patch.size() / v2.size());
+  std::printf("patch ops: %llu copy / %llu add, %llu literal bytes, "
+              "encoded in %.3f s\n",
+              static_cast<unsigned long long>(stats.copy_ops),
+              static_cast<unsigned long long>(stats.add_ops),
+              static_cast<unsigned long long>(stats.add_bytes), encode_s);
+  std::printf("device ram: %zu bytes receiver (%zu decoder) + %zu frame\n\n",
+              sizeof(ota::OtaReceiver), sizeof(ota::DeltaApplier),
+              ota::kMaxFrameSize);
+
+  const RunResult rf = run_update(setup, v1, v2, v2, full);
+  const RunResult rd = run_update(setup, v1, v2, patch, diff);
+  std::printf("%-6s %10s %10s %9s %10s %10s %7s %9s %9s %8s %s\n", "mode",
+              "payload", "link_B", "air_s", "prog_B", "read_B", "erases",
+              "flash_s", "device_s", "wall_s", "result");
+  print_row("full", full.size, rf);
+  print_row("delta", diff.size, rd);
+  std::printf("\nlink bytes saved: %.1f%%, device time saved: %.1f%%\n",
+              100.0 * (1.0 - static_cast<double>(rd.link_bytes) /
+                                 static_cast<double>(rf.link_bytes)),
+              100.0 * (1.0 - (rd.airtime_s + rd.flash_s) /
+                                 (rf.airtime_s + rf.flash_s)));
+  return rf.match && rd.match ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+// Builds a delta OTA patch and prints the offer fields that go with it.
+//
+//   delta_gen BASE TARGET PATCH [--max_add=N] [--block=N]
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "common/crc32.h"
+#include "delta/delta_encoder.h"
+#include "sim/file_io.h"
+#include "sim/flags.h"
+
+using namespace ct;
+
+int main(int argc, char** argv) {
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]).rfind("--", 0) != 0) paths.push_back(argv[i]);
+  }
+  if (paths.size() != 3) {
+    std::fprintf(stderr, "usage: delta_gen BASE TARGET PATCH [--max_add=N]\n");
+    return 2;
+  }
+  sim::Flags flags(argc, argv);
+  delta::EncoderOptions options;
+  options.max_add =
+      static_cast<uint32_t>(flags.get_u64("max_add", options.max_add));
+  options.block_size =
+      static_cast<uint32_t>(flags.get_u64("block", options.block_size));
+
+  std::vector<uint8_t> base;
+  std::vector<uint8_t> target;
+  if (!sim::read_file(paths[0], &base) || !sim::read_file(paths[1], &target)) {
+    std::fprintf(stderr, "cannot read input images\n");
+    return 1;
+  }
+  delta::PatchStats stats;
+  const std::vector<uint8_t> patch =
+      delta::encode_delta(base, target, options, &stats);
+  if (!sim::write_file(paths[2], patch)) {
+    std::fprintf(stderr, "cannot write %s\n", paths[2].c_str());
+    return 1;
+  }
+
+  std::printf("base:   %zu bytes crc32=%08x\n", base.size(),
+              crc32(base.data(), base.size()));
+  std::printf("target: %zu bytes crc32=%08x\n", target.size(),
+              crc32(target.data(), target.size()));
+  std::printf("patch:  %zu bytes crc32=%08x (%.2f%% of target)\n",
+              patch.size(), crc32(patch.data(), patch.size()),
+              100.0 * patch.size() / (target.empty() ? 1 : target.size()));
+  std::printf("ops:    %llu copy (%llu bytes), %llu add (%llu bytes)\n",
+              static_cast<unsigned long long>(stats.copy_ops),
+              static_cast<unsigned long long>(stats.copy_bytes),
+              static_cast<unsigned long long>(stats.add_ops),
+              static_cast<unsigned long long>(stats.add_bytes));
+  return 0;
+}
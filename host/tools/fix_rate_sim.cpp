@@ -0,0 +1,323 @@
+// Replays a 1 Hz motion/position trace against the adaptive fix scheduler
+// and against fixed-rate polling, and compares fixes, GNSS energy and how
+// far the reconstructed track strays from the true one.
+//
+//   fix_rate_sim [--trace=CSV | --hours=N --seed=N] [--save_trace=CSV]
+//                [--fixed=10,30,60,300] [--noise_m=M]
+//
+// The track between fixes is reconstructed by linear interpolation, as the
+// app would draw it; error is measured every second of the trace.
+//
+// Before the replay a scripted scenario walks the scheduler through its
+// rules (backoff at rest, waking at wake_mg, the hysteresis band, settle_s,
+// and the halving/doubling clamp while moving). The replay itself must keep
+// every gap between fixes within rest_interval_s and take fewer fixes than
+// fixed 10 s polling. The tool exits non-zero if any check fails, and
+// refuses an empty trace or a zero --fixed interval up front.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sim/flags.h"
+#include "sim/motion_trace.h"
+#include "track/fix_scheduler.h"
+#include "track/geo.h"
+
+using namespace ct;
+
+namespace {
+
+// GNSS receiver cost. Time to fix depends on how stale its ephemeris and
+// position estimate are, i.e. on the time since the previous fix.
+struct EnergyModel {
+  double gnss_mw = 25.0;
+  double tracking_s = 1.0;  // previous fix under tracking_window_s ago
+  double hot_s = 4.0;       // under hot_window_s
+  double warm_s = 28.0;
+  uint32_t tracking_window_s = 60;
+  uint32_t hot_window_s = 4 * 3600;
+  double baseline_mw = 0.05;  // MCU sleep + accelerometer
+
+  double fix_seconds(uint32_t since_last_s) const {
+    if (since_last_s <= tracking_window_s) return tracking_s;
+    if (since_last_s <= hot_window_s) return hot_s;
+    return warm_s;
+  }
+};
+
+struct PolicyResult {
+  std::string name;
+  uint64_t fixes = 0;
+  double gnss_on_s = 0.0;
+  double energy_j = 0.0;
+  double mean_error_m = 0.0;
+  double p95_error_m = 0.0;
+  double max_error_m = 0.0;
+};
+
+class Evaluator {
+ public:
+  Evaluator(const std::vector<sim::MotionSample>& trace, double noise_m,
+            uint32_t seed)
+      : trace_(trace) {
+    // Every policy sees the same receiver error at a given second.
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> n(0.0, noise_m);
+    noise_.resize(trace.size());
+    for (auto& e : noise_) e = {n(rng), n(rng)};
+  }
+
+  track::Fix fix_at(size_t i) const {
+    track::Fix f = trace_[i].position();
+    const float lat_m = track::kMetersPerDegree * 1e-7f;
+    f.lat_e7 += static_cast<int32_t>(noise_[i].first / lat_m);
+    f.lon_e7 +=
+        static_cast<int32_t>(noise_[i].second / track::lon_scale_m(f.lat_e7));
+    return f;
+  }
+
+  PolicyResult score(const std::string& name,
+                     const std::vector<size_t>& fix_indices,
+                     const EnergyModel& energy) const {
+    PolicyResult r;
+    r.name = name;
+    r.fixes = fix_indices.size();
+    uint32_t prev = 0;
+    bool first = true;
+    for (size_t i : fix_indices) {
+      const uint32_t t = trace_[i].time_s;
+      r.gnss_on_s += energy.fix_seconds(first ? UINT32_MAX : t - prev);
+      prev = t;
+      first = false;
+    }
+    const double span_s = static_cast<double>(trace_.size());
+    r.energy_j =
+        (r.gnss_on_s * energy.gnss_mw + span_s * energy.baseline_mw) / 1000.0;
+
+    std::vector<float> errors;
+    errors.reserve(trace_.size());
+    size_t k = 0;
+    for (size_t i = 0; i < trace_.size(); ++i) {
+      while (k + 1 < fix_indices.size() && fix_indices[k + 1] <= i) ++k;
+      errors.push_back(
+          track::distance_m(trace_[i].position(), estimate(fix_indices, k, i)));
+    }
+    double sum = 0.0;
+    for (float e : errors) sum += e;
+    r.mean_error_m = sum / errors.size();
+    std::sort(errors.begin(), errors.end());
+    r.p95_error_m = errors[errors.size() * 95 / 100];
+    r.max_error_m = errors.back();
+    return r;
+  }
+
+ private:
+  // Position the app would show at second |i|, given fix |k| is the last one
+  // at or before it.
+  track::Fix estimate(const std::vector<size_t>& fixes, size_t k,
+                      size_t i) const {
+    if (fixes.empty()) return trace_[0].position();
+    const track::Fix a = fix_at(fixes[k]);
+    if (i <= fixes[k] || k + 1 == fixes.size()) return a;
+    const track::Fix b = fix_at(fixes[k + 1]);
+    const double w = static_cast<double>(i - fixes[k]) /
+                     static_cast<double>(fixes[k + 1] - fixes[k]);
+    track::Fix f = a;
+    f.lat_e7 = a.lat_e7 + static_cast<int32_t>((b.lat_e7 - a.lat_e7) * w);
+    f.lon_e7 = a.lon_e7 + static_cast<int32_t>((b.lon_e7 - a.lon_e7) * w);
+    return f;
+  }
+
+  const std::vector<sim::MotionSample>& trace_;
+  std::vector<std::pair<double, double>> noise_;
+};
+
+std::vector<size_t> run_fixed(size_t samples, uint32_t interval_s) {
+  std::vector<size_t> fixes;
+  for (size_t i = 0; i < samples; i += interval_s) fixes.push_back(i);
+  return fixes;
+}
+
+std::vector<size_t> run_adaptive(const std::vector<sim::MotionSample>& trace,
+                                 const Evaluator& eval,
+                                 const track::FixPolicy& policy) {
+  std::vector<size_t> fixes;
+  track::FixScheduler scheduler(policy);
+  for (size_t i = 0; i < trace.size(); ++i) {
+    scheduler.on_motion(trace[i].time_s, trace[i].activity_mg);
+    if (scheduler.due(trace[i].time_s)) {
+      scheduler.on_fix(eval.fix_at(i));
+      fixes.push_back(i);
+    }
+  }
+  return fixes;
+}
+
+// Fix |north_m| north of a fixed point at time |t|.
+track::Fix fix_north(uint32_t t, double north_m) {
+  track::Fix f;
+  f.time_s = t;
+  f.lat_e7 = 473769000 +
+             static_cast<int32_t>(north_m * 1e7 / track::kMetersPerDegree);
+  f.lon_e7 = 85417000;
+  return f;
+}
+
+// Drives a scheduler through a scripted day; returns the rules it broke.
+std::vector<std::string> check_scheduler(const track::FixPolicy& p) {
+  using State = track::FixScheduler::State;
+  std::vector<std::string> broken;
+  auto expect = [&broken](bool ok, const char* rule) {
+    if (!ok && (broken.empty() || broken.back() != rule)) {
+      broken.push_back(rule);
+    }
+  };
+  track::FixScheduler s(p);
+  uint32_t t = 1000;
+  expect(s.due(t) && s.state() == State::kResting, "first fix due at once");
+
+  // Resting: the interval doubles after every fix up to rest_interval_s.
+  uint32_t want = p.min_interval_s;
+  for (int i = 0; i < 12; ++i) {
+    s.on_motion(t, 0);
+    s.on_fix(fix_north(t, 0.0));
+    want = std::min(want * 2, p.rest_interval_s);
+    expect(s.state() == State::kResting && s.interval_s() == want &&
+               s.next_fix_s() == t + want,
+           "resting interval doubles up to rest_interval_s");
+    t = s.next_fix_s();
+  }
+
+  // Activity in the hysteresis band does not wake a resting cat; reaching
+  // wake_mg does, and the next fix is due at once.
+  const uint16_t band_mg = static_cast<uint16_t>((p.rest_mg + p.wake_mg) / 2);
+  t -= p.rest_interval_s / 2;
+  s.on_motion(t, band_mg);
+  expect(s.state() == State::kResting && !s.due(t),
+         "activity below wake_mg keeps resting");
+  ++t;
+  s.on_motion(t, p.wake_mg);
+  expect(s.state() == State::kMoving && s.due(t) &&
+             s.interval_s() == p.min_interval_s,
+         "activity at wake_mg wakes and pulls the fix forward");
+
+  // Moving: a close fix doubles the interval, a far one halves it, one in
+  // between keeps it; always within [min_interval_s, moving_max_interval_s].
+  const float close_m = p.slow_down_m / 2;
+  const float far_m = p.speed_up_m * 2;
+  const float mid_m = (p.slow_down_m + p.speed_up_m) / 2;
+  const float steps[] = {close_m, close_m, close_m, close_m, close_m, close_m,
+                         close_m, far_m,   far_m,   far_m,   far_m,   far_m,
+                         far_m,   far_m,   mid_m,   mid_m,   close_m};
+  double north = 0.0;  // where the last resting fix was taken
+  want = p.min_interval_s;
+  for (float step : steps) {
+    s.on_motion(t, p.wake_mg);
+    north += step;
+    s.on_fix(fix_north(t, north));
+    if (step > p.speed_up_m) {
+      want /= 2;
+    } else if (step < p.slow_down_m) {
+      want *= 2;
+    }
+    want = std::max(p.min_interval_s, std::min(want, p.moving_max_interval_s));
+    expect(s.state() == State::kMoving && s.interval_s() == want,
+           "moving interval halves/doubles within its clamp");
+    t = s.next_fix_s();
+  }
+
+  // Activity above rest_mg keeps the cat moving however long it lasts; then
+  // it takes settle_s of stillness, not a second less, to rest again.
+  for (uint32_t k = 0; k < 3 * p.settle_s; ++k) s.on_motion(++t, band_mg);
+  expect(s.state() == State::kMoving, "activity above rest_mg stays moving");
+  const uint32_t last_active = t;
+  for (uint32_t k = 1; k < p.settle_s; ++k) s.on_motion(last_active + k, 0);
+  expect(s.state() == State::kMoving, "stays moving until settle_s is up");
+  s.on_motion(last_active + p.settle_s, 0);
+  expect(s.state() == State::kResting, "rests after settle_s of stillness");
+  return broken;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sim::Flags flags(argc, argv);
+  const uint32_t seed = static_cast<uint32_t>(flags.get_u64("seed", 1));
+  std::vector<sim::MotionSample> trace;
+  if (flags.has("trace")) {
+    if (!sim::load_motion_trace(flags.get("trace", ""), &trace)) {
+      std::fprintf(stderr, "cannot load trace\n");
+      return 1;
+    }
+  } else {
+    const double hours = flags.get_double("hours", 24.0);
+    trace = sim::make_motion_trace(static_cast<uint32_t>(hours * 3600), seed);
+  }
+  if (trace.empty()) {
+    std::fprintf(stderr, "empty trace\n");
+    return 1;
+  }
+  if (flags.has("save_trace") &&
+      !sim::save_motion_trace(flags.get("save_trace", ""), trace)) {
+    std::fprintf(stderr, "cannot save trace\n");
+    return 1;
+  }
+
+  std::vector<uint32_t> fixed;
+  std::stringstream list(flags.get("fixed", "10,30,60,300"));
+  for (std::string item; std::getline(list, item, ',');) {
+    if (item.empty()) continue;
+    fixed.push_back(static_cast<uint32_t>(std::stoul(item)));
+    if (fixed.back() == 0) {
+      std::fprintf(stderr, "--fixed intervals must be at least 1 s\n");
+      return 1;
+    }
+  }
+
+  const track::FixPolicy policy;
+  const std::vector<std::string> broken = check_scheduler(policy);
+
+  const Evaluator eval(trace, flags.get_double("noise_m", 3.0), seed);
+  const EnergyModel energy;
+  const std::vector<size_t> adaptive = run_adaptive(trace, eval, policy);
+  size_t longest_gap = 0;
+  for (size_t k = 1; k < adaptive.size(); ++k) {
+    longest_gap = std::max(longest_gap, adaptive[k] - adaptive[k - 1]);
+  }
+  const size_t fixed_10s = run_fixed(trace.size(), 10).size();
+  std::vector<PolicyResult> results;
+  results.push_back(eval.score("adaptive", adaptive, energy));
+  for (uint32_t interval : fixed) {
+    results.push_back(eval.score("fixed " + std::to_string(interval) + " s",
+                                 run_fixed(trace.size(), interval), energy));
+  }
+
+  const double days = trace.size() / 86400.0;
+  std::printf("trace: %zu s (%.2f days)\n\n", trace.size(), days);
+  std::printf("%-12s %8s %10s %10s %10s %9s %9s\n", "policy", "fixes/day",
+              "gnss_s/day", "J/day", "mean_err_m", "p95_err_m", "max_err_m");
+  for (const PolicyResult& r : results) {
+    std::printf("%-12s %8.0f %10.0f %10.2f %10.1f %9.1f %9.1f\n",
+                r.name.c_str(), r.fixes / days, r.gnss_on_s / days,
+                r.energy_j / days, r.mean_error_m, r.p95_error_m,
+                r.max_error_m);
+  }
+
+  std::printf("\nscheduler rules: %s\n", broken.empty() ? "ok" : "BROKEN");
+  for (const std::string& rule : broken) {
+    std::printf("  broken: %s\n", rule.c_str());
+  }
+  const bool gaps_ok = longest_gap <= policy.rest_interval_s;
+  const bool fewer = adaptive.size() < fixed_10s;
+  std::printf("longest gap between fixes: %zu s (limit %u s) %s\n",
+              longest_gap, policy.rest_interval_s, gaps_ok ? "ok" : "OVER");
+  std::printf("adaptive fixes: %zu vs %zu at fixed 10 s %s\n",
+              adaptive.size(), fixed_10s, fewer ? "ok" : "NOT_FEWER");
+  const bool ok = broken.empty() && gaps_ok && fewer;
+  std::printf("result: %s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
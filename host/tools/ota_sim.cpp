@@ -0,0 +1,164 @@
+// Runs a complete OTA session against a file-backed flash over a lossy link
+// and checks that the slot ends up byte-identical to the image.
+//
+//   ota_sim [--image=PATH | --image_kib=N] [--chunk=BYTES] [--drop=P]
+//           [--corrupt=P] [--reboot] [--seed=N] [--workdir=DIR]
+//
+// --reboot models a device reset on every link loss: the receiver is rebuilt
+// from flash, so resumption relies solely on the persisted journal.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/byte_io.h"
+#include "ota/ota_receiver.h"
+#include "sim/faulty_transport.h"
+#include "sim/file_flash.h"
+#include "sim/flags.h"
+#include "sim/ota_sender.h"
+
+using namespace ct;
+
+namespace {
+
+constexpr uint32_t kSectorSize = 4096;
+constexpr uint32_t kStateSize = 2 * kSectorSize;
+
+bool write_random_image(const std::string& path, uint32_t size, uint32_t seed) {
+  FILE* f = std::fopen(path.c_str(), "wb");
+  if (f == nullptr) return false;
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> buf(4096);
+  for (uint32_t off = 0; off < size; off += buf.size()) {
+    for (auto& b : buf) b = static_cast<uint8_t>(rng());
+    const size_t n = std::min<size_t>(buf.size(), size - off);
+    if (std::fwrite(buf.data(), 1, n, f) != n) {
+      std::fclose(f);
+      return false;
+    }
+  }
+  return std::fclose(f) == 0;
+}
+
+bool slot_matches(const Partition& slot, sim::ImageSource* image) {
+  uint8_t a[4096];
+  uint8_t b[4096];
+  for (uint32_t off = 0; off < image->size(); off += sizeof(a)) {
+    const uint32_t n = std::min<uint32_t>(sizeof(a), image->size() - off);
+    if (!is_ok(slot.read(off, a, n)) || !is_ok(image->read(off, b, n))) {
+      return false;
+    }
+    if (!std::equal(a, a + n, b)) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sim::Flags flags(argc, argv);
+  const std::string workdir = flags.get("workdir", "/tmp");
+  const uint32_t seed = static_cast<uint32_t>(flags.get_u64("seed", 1));
+  const uint16_t chunk = static_cast<uint16_t>(flags.get_u64("chunk", 512));
+  const bool reboot = flags.has("reboot");
+
+  std::string image_path = flags.get("image", "");
+  if (image_path.empty()) {
+    image_path = workdir + "/ota_sim_image.bin";
+    const uint32_t size =
+        static_cast<uint32_t>(flags.get_u64("image_kib", 512) * 1024);
+    if (!write_random_image(image_path, size, seed)) {
+      std::fprintf(stderr, "cannot write %s\n", image_path.c_str());
+      return 1;
+    }
+  }
+
+  sim::FileImageSource image;
+  if (!is_ok(image.open(image_path))) {
+    std::fprintf(stderr, "cannot open %s\n", image_path.c_str());
+    return 1;
+  }
+  ota::ImageInfo info;
+  Status s = sim::describe_image(&image, chunk, 1, &info);
+  if (!is_ok(s)) {
+    std::fprintf(stderr, "describe_image: %s\n", status_name(s));
+    return 1;
+  }
+
+  // Flash map: [slot A][slot B][session state]. The update targets slot B.
+  const uint32_t slot_size = align_up(image.size(), kSectorSize);
+  sim::FileFlash flash;
+  s = flash.open(workdir + "/ota_sim_flash.bin", 2 * slot_size + kStateSize,
+                 kSectorSize, true);
+  if (!is_ok(s)) {
+    std::fprintf(stderr, "flash open: %s\n", status_name(s));
+    return 1;
+  }
+  const Partition slot_a(&flash, 0, slot_size);
+  const Partition slot_b(&flash, slot_size, slot_size);
+  const Partition state(&flash, 2 * slot_size, kStateSize);
+
+  auto receiver = std::make_unique<ota::OtaReceiver>(slot_b, slot_a, state);
+  sim::FaultConfig fault;
+  fault.drop_rate = flags.get_double("drop", 0.005);
+  fault.corrupt_rate = flags.get_double("corrupt", 0.005);
+  fault.seed = seed;
+  sim::FaultyTransport link(
+      [&receiver](const uint8_t* frame, size_t len, uint8_t* reply) {
+        return receiver->handle_frame(frame, len, reply);
+      },
+      fault);
+  if (reboot) {
+    link.set_on_reconnect([&] {
+      receiver = std::make_unique<ota::OtaReceiver>(slot_b, slot_a, state);
+    });
+  }
+
+  sim::OtaSender sender(&link, &image, info);
+  const auto t0 = std::chrono::steady_clock::now();
+  s = sender.run(100000);
+  const double wall_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+          .count();
+  const bool match = is_ok(s) && receiver->verified() &&
+                     slot_matches(slot_b, &image);
+
+  const sim::FlashStats& fs = flash.stats();
+  const sim::LinkStats& ls = link.stats();
+  const sim::SenderStats& ss = sender.stats();
+  const double device_s = (fs.modeled_us + ls.airtime_us) / 1e6;
+  std::printf("result:             %s\n", match ? "ok" : status_name(s));
+  std::printf("image_bytes:        %u\n", info.size);
+  std::printf("chunk_size:         %u\n", info.chunk_size);
+  std::printf("chunks:             %u\n", info.chunk_count());
+  std::printf("checkpoint_every:   %u chunks\n",
+              receiver->checkpoint_interval());
+  std::printf("chunks_sent:        %llu\n",
+              static_cast<unsigned long long>(ss.chunks_sent));
+  std::printf("retransmits:        %llu\n",
+              static_cast<unsigned long long>(ss.retransmits));
+  std::printf("reconnects:         %llu\n",
+              static_cast<unsigned long long>(ss.reconnects));
+  std::printf("resumes:            %llu\n",
+              static_cast<unsigned long long>(ss.resumes));
+  std::printf("corrupted_frames:   %llu\n",
+              static_cast<unsigned long long>(ls.corruptions));
+  std::printf("uplink_overhead:    %.3f x image\n",
+              static_cast<double>(ls.bytes_up) / info.size);
+  std::printf("flash_programmed:   %llu bytes\n",
+              static_cast<unsigned long long>(fs.bytes_programmed));
+  std::printf("flash_erases:       %llu sectors\n",
+              static_cast<unsigned long long>(fs.sectors_erased));
+  std::printf("receiver_ram:       %zu bytes + %zu frame buffer\n",
+              sizeof(ota::OtaReceiver), ota::kMaxFrameSize);
+  std::printf("host_wall:          %.3f s (%.1f MiB/s)\n", wall_s,
+              info.size / wall_s / (1024.0 * 1024.0));
+  std::printf("modeled_device:     %.2f s (%.1f KiB/s)\n", device_s,
+              info.size / device_s / 1024.0);
+  return match ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+// Appends a synthetic cat track to a TrackLog on file-backed flash, replays
+// it after simulated power losses and checks nothing synced went missing.
+//
+//   track_log_bench [--fixes=N] [--log_kib=N] [--sync_every=N]
+//                   [--reboot_every=N] [--interval=S] [--seed=N]
+//                   [--workdir=DIR]
+//
+// --sync_every=0 leaves syncing to page fills. --reboot_every drops the log
+// object without a sync every N fixes, losing whatever was still buffered.
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sim/file_flash.h"
+#include "sim/flags.h"
+#include "sim/synthetic_track.h"
+#include "track/track_log.h"
+
+using namespace ct;
+
+namespace {
+
+constexpr uint32_t kSectorSize = 4096;
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sim::Flags flags(argc, argv);
+  const uint32_t fixes = static_cast<uint32_t>(flags.get_u64("fixes", 200000));
+  const uint32_t log_size =
+      static_cast<uint32_t>(flags.get_u64("log_kib", 256) * 1024);
+  const uint64_t sync_every = flags.get_u64("sync_every", 0);
+  const uint64_t reboot_every = flags.get_u64("reboot_every", 0);
+  sim::TrackModel model;
+  model.interval_s = static_cast<uint32_t>(flags.get_u64("interval", 30));
+  const uint32_t seed = static_cast<uint32_t>(flags.get_u64("seed", 1));
+
+  const std::vector<track::Fix> fixes_in =
+      sim::make_cat_track(fixes, seed, model);
+
+  sim::FileFlash flash;
+  Status s = flash.open(flags.get("workdir", "/tmp") + "/track_log_flash.bin",
+                        log_size, kSectorSize, true);
+  if (!is_ok(s)) {
+    std::fprintf(stderr, "flash open: %s\n", status_name(s));
+    return 1;
+  }
+  const Partition part(&flash, 0, log_size);
+
+  // Fixes the log has promised to keep, in order; the reader must return a
+  // suffix of this list (the ring may have dropped the oldest).
+  std::vector<track::Fix> durable;
+  durable.reserve(fixes_in.size());
+  uint64_t lost = 0;
+  uint64_t reboots = 0;
+  track::TrackLog::Stats log_stats;
+  auto add_stats = [&log_stats](const track::TrackLog::Stats& st) {
+    log_stats.appended += st.appended;
+    log_stats.pages_opened += st.pages_opened;
+    log_stats.pages_skipped += st.pages_skipped;
+    log_stats.early_page_breaks += st.early_page_breaks;
+    log_stats.sectors_erased += st.sectors_erased;
+  };
+
+  auto log = std::make_unique<track::TrackLog>(part);
+  const auto t0 = std::chrono::steady_clock::now();
+  s = log->mount();
+  for (size_t i = 0; i < fixes_in.size() && is_ok(s); ++i) {
+    s = log->append(fixes_in[i]);
+    durable.push_back(fixes_in[i]);
+    if (is_ok(s) && sync_every != 0 && (i + 1) % sync_every == 0) {
+      s = log->sync();
+    }
+    if (is_ok(s) && reboot_every != 0 && (i + 1) % reboot_every == 0) {
+      const uint32_t pending = log->pending();
+      durable.resize(durable.size() - pending);
+      lost += pending;
+      ++reboots;
+      add_stats(log->stats());
+      log = std::make_unique<track::TrackLog>(part);
+      s = log->mount();
+    }
+  }
+  if (is_ok(s)) s = log->sync();
+  const double append_s = seconds_since(t0);
+  add_stats(log->stats());
+  if (!is_ok(s)) {
+    std::fprintf(stderr, "append: %s\n", status_name(s));
+    return 1;
+  }
+  const sim::FlashStats write_stats = flash.stats();
+
+  // Power-cycle once more and replay from flash alone.
+  log = std::make_unique<track::TrackLog>(part);
+  const auto t1 = std::chrono::steady_clock::now();
+  s = log->mount();
+  std::vector<track::Fix> replayed;
+  track::TrackReader reader(*log);
+  while (is_ok(s)) {
+    track::Fix fix;
+    bool end = false;
+    s = reader.next(&fix, &end);
+    if (end) break;
+    replayed.push_back(fix);
+  }
+  const double replay_s = seconds_since(t1);
+  const bool match =
+      is_ok(s) && !replayed.empty() && replayed.size() <= durable.size() &&
+      std::equal(replayed.begin(), replayed.end(),
+                 durable.end() - static_cast<long>(replayed.size()));
+
+  const double n = static_cast<double>(fixes);
+  std::printf("result:             %s\n", match ? "ok" : "MISMATCH");
+  std::printf("fixes_appended:     %u\n", fixes);
+  std::printf("fixes_retained:     %zu (ring of %u pages, %u fixes/page)\n",
+              replayed.size(), log->page_count(),
+              track::TrackLog::kRecordsPerPage + 1);
+  std::printf("reboots:            %llu (%llu unsynced fixes lost)\n",
+              static_cast<unsigned long long>(reboots),
+              static_cast<unsigned long long>(lost));
+  std::printf("early_page_breaks:  %llu\n",
+              static_cast<unsigned long long>(log_stats.early_page_breaks));
+  std::printf("append_rate:        %.0f records/s (host)\n", n / append_s);
+  std::printf("replay_rate:        %.0f records/s (host)\n",
+              replayed.size() / replay_s);
+  std::printf("bytes_per_fix:      %.2f programmed (raw fix %zu)\n",
+              write_stats.bytes_programmed / n, sizeof(track::Fix));
+  std::printf("write_amplification:%.3f (programmed / raw fix bytes)\n",
+              write_stats.bytes_programmed / (n * sizeof(track::Fix)));
+  std::printf("program_ops_per_fix:%.3f\n", write_stats.program_ops / n);
+  std::printf("erases:             %llu sectors (%.4f per fix)\n",
+              static_cast<unsigned long long>(write_stats.sectors_erased),
+              write_stats.sectors_erased / n);
+  std::printf("device_time:        %.1f us/fix (modeled flash)\n",
+              write_stats.modeled_us / n);
+  std::printf("log_ram:            %zu bytes\n", sizeof(track::TrackLog));
+  return match ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+// Drives the uplink batcher with synthetic tracks at several fix rates and
+// ships every frame through a UDP loopback link to a decoding server stub.
+//
+//   uplink_bench [--intervals=5,15,30,60,300] [--hours=N] [--frame_bytes=N]
+//                [--max_age=S] [--seed=N]
+//
+// The baseline is one single-fix frame (and radio session) per fix. Tracks
+// have no indoor gaps, so every row covers exactly --hours at its fix rate.
+// A row whose frames did not deliver every fix intact reads LOSSY.
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/byte_io.h"
+#include "sim/flags.h"
+#include "sim/loopback_transport.h"
+#include "sim/synthetic_track.h"
+#include "track/uplink_batcher.h"
+
+using namespace ct;
+
+namespace {
+
+struct RateResult {
+  uint64_t fixes = 0;
+  uint64_t frames = 0;
+  uint64_t bytes = 0;
+  double hours = 0.0;
+  double wall_s = 0.0;
+  bool lossless = false;
+  Status status = Status::kOk;
+};
+
+RateResult run_rate(uint32_t interval_s, double hours,
+                    const track::BatchPolicy& policy, uint32_t seed) {
+  RateResult r;
+  sim::TrackModel model;
+  model.interval_s = interval_s;
+  model.gap_chance = 0.0;
+  const auto count = static_cast<uint32_t>(hours * 3600 / interval_s);
+  const std::vector<track::Fix> fixes = sim::make_cat_track(count, seed, model);
+  if (fixes.empty()) return r;
+
+  std::vector<track::Fix> received;
+  received.reserve(fixes.size());
+  sim::LoopbackTransport link(
+      [&received](const uint8_t* frame, size_t len, uint8_t* reply) {
+        track::UplinkHeader header;
+        track::Fix batch[track::kUplinkMaxFixes];
+        const Status s = track::decode_uplink_frame(frame, len, &header, batch,
+                                                    track::kUplinkMaxFixes);
+        if (is_ok(s)) {
+          received.insert(received.end(), batch, batch + header.count);
+        }
+        reply[0] = static_cast<uint8_t>(s);
+        put_u16(reply + 1, header.seq);
+        return track::kUplinkAckSize;
+      });
+  r.status = link.open();
+  if (!is_ok(r.status)) return r;
+
+  track::UplinkBatcher batcher(0xCA7, policy);
+  uint8_t frame[track::kUplinkMaxFrameSize];
+  auto send = [&]() -> Status {
+    const size_t len = batcher.take_frame(frame);
+    if (len == 0) return Status::kOk;
+    uint8_t ack[sim::kMaxReplySize];
+    size_t ack_len = 0;
+    CT_RETURN_IF_ERROR(link.exchange(frame, len, ack, sizeof(ack), &ack_len));
+    if (ack_len != track::kUplinkAckSize) return Status::kCorrupt;
+    ++r.frames;
+    r.bytes += len;
+    return static_cast<Status>(ack[0]);
+  };
+
+  const auto t0 = std::chrono::steady_clock::now();
+  for (const track::Fix& fix : fixes) {
+    // The device wakes for each fix; that is also when it checks the age cap.
+    if (batcher.due(fix.time_s)) r.status = send();
+    bool full = false;
+    if (is_ok(r.status)) r.status = batcher.add(fix, &full);
+    if (is_ok(r.status) && full) r.status = send();
+    if (!is_ok(r.status)) return r;
+  }
+  r.status = send();
+  r.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           t0)
+                 .count();
+  r.fixes = fixes.size();
+  r.hours = double(fixes.size()) * interval_s / 3600.0;
+  r.lossless = is_ok(r.status) && received == fixes;
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sim::Flags flags(argc, argv);
+  track::BatchPolicy policy;
+  policy.max_frame_bytes = static_cast<uint16_t>(
+      flags.get_u64("frame_bytes", policy.max_frame_bytes));
+  policy.max_age_s =
+      static_cast<uint32_t>(flags.get_u64("max_age", policy.max_age_s));
+  const double hours = flags.get_double("hours", 24.0);
+  const uint32_t seed = static_cast<uint32_t>(flags.get_u64("seed", 1));
+
+  std::vector<uint32_t> intervals;
+  std::stringstream list(flags.get("intervals", "5,15,30,60,300"));
+  for (std::string item; std::getline(list, item, ',');) {
+    if (item.empty()) continue;
+    intervals.push_back(static_cast<uint32_t>(std::stoul(item)));
+    if (intervals.back() == 0 || intervals.back() > hours * 3600) {
+      std::fprintf(stderr,
+                   "--intervals must be at least 1 s and fit in --hours\n");
+      return 1;
+    }
+  }
+
+  const double single_fix_frame =
+      track::kUplinkHeaderSize + track::kUplinkTrailerSize;
+  std::printf(
+      "frame cap %u bytes, age cap %u s, single-fix frame %.0f bytes\n\n",
+      policy.max_frame_bytes, policy.max_age_s, single_fix_frame);
+  std::printf("%8s %8s %8s %9s %11s %9s %10s %10s %s\n", "fix_s", "fixes",
+              "frames", "frames/h", "fixes/frame", "bytes/fix", "baseline/h",
+              "saved", "result");
+  bool ok = true;
+  for (uint32_t interval : intervals) {
+    const RateResult r = run_rate(interval, hours, policy, seed);
+    ok = ok && r.lossless;
+    const double fixes = static_cast<double>(r.fixes);
+    const char* verdict = status_name(r.status);
+    if (r.lossless) {
+      verdict = "ok";
+    } else if (is_ok(r.status)) {
+      verdict = "LOSSY";
+    }
+    std::printf("%8u %8llu %8llu %9.1f %11.1f %9.2f %10.1f %9.1f%% %s\n",
+                interval, static_cast<unsigned long long>(r.fixes),
+                static_cast<unsigned long long>(r.frames), r.frames / r.hours,
+                fixes / r.frames, r.bytes / fixes, fixes / r.hours,
+                100.0 * (1.0 - r.frames / fixes), verdict);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,328 @@
+#include "geofence/fence_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace ct {
+namespace server {
+namespace {
+
+// Local coordinates stay below this, so orientation products fit in int64.
+constexpr int64_t kMaxSpan = int64_t{1} << 30;
+// Smallest cell edge, in 1e-7 degrees (about 1.1 m of latitude). Leaves room
+// to move a reference point off a fence edge without leaving its cell.
+constexpr int64_t kMinCellSize = 16;
+
+template <typename P>
+int64_t orient(const P& a, const P& b, const P& c) {
+  return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// Boundary rule shared by every test below: a query or reference point c
+// stands for c + (d, e), with infinitesimals 0 < e << d, i.e. a hair to the
+// right and a far smaller hair up. No such point lies on an integer edge, so
+// a point on a fence edge or vertex gets the same answer on every path.
+//
+// Sign of orient(a, b, c + s * (d, e)) for s = +1 or -1; 0 only if a == b.
+template <typename P>
+int shifted_side(const P& a, const P& b, const P& c, int s) {
+  const int64_t o = orient(a, b, c);
+  if (o != 0) return o > 0 ? 1 : -1;
+  // orient(a, b, c + (d, e)) = o - (b.y - a.y) * d + (b.x - a.x) * e.
+  const int64_t t = b.y != a.y ? a.y - b.y : b.x - a.x;
+  if (t == 0) return 0;
+  return (t > 0) == (s > 0) ? 1 : -1;
+}
+
+// True when segment pq crosses edge ab, both ends shifted as above.
+template <typename P>
+bool crosses(const P& p, const P& q, const P& a, const P& b) {
+  const int sa = shifted_side(p, q, a, -1);
+  const int sb = shifted_side(p, q, b, -1);
+  if (sa == 0 || sa == sb) return false;
+  return shifted_side(a, b, p, 1) != shifted_side(a, b, q, 1);
+}
+
+// Horizontal ray from p, shifted as above, towards +x crosses edge ab. The
+// shift makes it half-open in y: a vertex at p.y counts as below the ray.
+template <typename P>
+bool ray_crosses(const P& p, const P& a, const P& b) {
+  if ((a.y > p.y) == (b.y > p.y)) return false;
+  return shifted_side(a, b, p, 1) == (b.y > a.y ? 1 : -1);
+}
+
+template <typename P>
+bool on_segment(const P& p, const P& a, const P& b) {
+  return orient(a, b, p) == 0 && p.x >= std::min(a.x, b.x) &&
+         p.x <= std::max(a.x, b.x) && p.y >= std::min(a.y, b.y) &&
+         p.y <= std::max(a.y, b.y);
+}
+
+// Segment ab touches the closed box [x0, x1] x [y0, y1].
+template <typename P>
+bool touches_box(const P& a, const P& b, int64_t x0, int64_t y0, int64_t x1,
+                 int64_t y1) {
+  if (std::max(a.x, b.x) < x0 || std::min(a.x, b.x) > x1 ||
+      std::max(a.y, b.y) < y0 || std::min(a.y, b.y) > y1) {
+    return false;
+  }
+  const P corners[4] = {{x0, y0}, {x1, y0}, {x0, y1}, {x1, y1}};
+  bool pos = false;
+  bool neg = false;
+  for (const P& c : corners) {
+    const int64_t o = orient(a, b, c);
+    pos |= o >= 0;
+    neg |= o <= 0;
+  }
+  return pos && neg;
+}
+
+}  // namespace
+
+Status FenceIndex::build(const std::vector<Fence>& fences,
+                         const FenceIndexOptions& options, FenceIndex* out) {
+  *out = FenceIndex();
+  if (fences.empty()) return Status::kOk;
+
+  int64_t min_lat = std::numeric_limits<int64_t>::max();
+  int64_t min_lon = min_lat;
+  int64_t max_lat = std::numeric_limits<int64_t>::min();
+  int64_t max_lon = max_lat;
+  for (const Fence& fence : fences) {
+    if (fence.vertices.size() < 3) return Status::kBadArgument;
+    for (const GeoPoint& v : fence.vertices) {
+      min_lat = std::min<int64_t>(min_lat, v.lat_e7);
+      max_lat = std::max<int64_t>(max_lat, v.lat_e7);
+      min_lon = std::min<int64_t>(min_lon, v.lon_e7);
+      max_lon = std::max<int64_t>(max_lon, v.lon_e7);
+    }
+  }
+  const int64_t span_x = max_lon - min_lon;
+  const int64_t span_y = max_lat - min_lat;
+  if (span_x >= kMaxSpan || span_y >= kMaxSpan) return Status::kOutOfRange;
+
+  FenceIndex& ix = *out;
+  ix.origin_lat_ = min_lat;
+  ix.origin_lon_ = min_lon;
+  ix.fence_edge_begin_.push_back(0);
+  for (const Fence& fence : fences) {
+    ix.fence_ids_.push_back(fence.id);
+    const size_t n = fence.vertices.size();
+    for (size_t i = 0; i < n; ++i) {
+      const GeoPoint& a = fence.vertices[i];
+      const GeoPoint& b = fence.vertices[(i + 1) % n];
+      const Edge e{ix.to_local(a.lat_e7, a.lon_e7),
+                   ix.to_local(b.lat_e7, b.lon_e7)};
+      if (e.a.x == e.b.x && e.a.y == e.b.y) continue;
+      ix.edges_.push_back(e);
+    }
+    ix.fence_edge_begin_.push_back(static_cast<uint32_t>(ix.edges_.size()));
+  }
+
+  // Square cells sized so the grid holds about cells_per_edge cells per edge.
+  const double area = static_cast<double>(span_x + 1) * (span_y + 1);
+  const double want = std::min<double>(
+      options.max_cells,
+      std::max(1.0, options.cells_per_edge * ix.edges_.size()));
+  int64_t size = std::max<int64_t>(
+      kMinCellSize, static_cast<int64_t>(std::ceil(std::sqrt(area / want))));
+  while (static_cast<uint64_t>(span_x / size + 1) * (span_y / size + 1) >
+         std::max<uint32_t>(options.max_cells, 1)) {
+    size += size / 8 + 1;
+  }
+  ix.cell_size_ = size;
+  ix.cells_x_ = static_cast<size_t>(span_x / size + 1);
+  ix.cells_y_ = static_cast<size_t>(span_y / size + 1);
+
+  std::vector<std::pair<uint32_t, Entry>> placed;
+  std::vector<uint32_t> boundary(ix.cell_count(), 0);  // fence + 1
+  std::vector<uint32_t> slot(ix.cell_count(), 0);      // into placed
+  std::vector<std::pair<uint32_t, uint32_t>> hits;  // (cell, edge)
+  std::vector<uint32_t> row_edges;
+
+  for (uint32_t f = 0; f < ix.fence_ids_.size(); ++f) {
+    const uint32_t eb = ix.fence_edge_begin_[f];
+    const uint32_t ee = ix.fence_edge_begin_[f + 1];
+    if (eb == ee) continue;
+
+    hits.clear();
+    int64_t fx0 = kMaxSpan, fy0 = kMaxSpan, fx1 = 0, fy1 = 0;
+    for (uint32_t e = eb; e < ee; ++e) {
+      const Edge& edge = ix.edges_[e];
+      const int64_t ex0 = std::min(edge.a.x, edge.b.x);
+      const int64_t ex1 = std::max(edge.a.x, edge.b.x);
+      const int64_t ey0 = std::min(edge.a.y, edge.b.y);
+      const int64_t ey1 = std::max(edge.a.y, edge.b.y);
+      fx0 = std::min(fx0, ex0);
+      fx1 = std::max(fx1, ex1);
+      fy0 = std::min(fy0, ey0);
+      fy1 = std::max(fy1, ey1);
+      // Closed cell boxes: an edge on a shared border belongs to both cells.
+      const int64_t cx0 = std::max<int64_t>(0, ex0 / size - 1);
+      const int64_t cy0 = std::max<int64_t>(0, ey0 / size - 1);
+      const int64_t cx1 =
+          std::min<int64_t>(static_cast<int64_t>(ix.cells_x_) - 1, ex1 / size);
+      const int64_t cy1 =
+          std::min<int64_t>(static_cast<int64_t>(ix.cells_y_) - 1, ey1 / size);
+      for (int64_t cy = cy0; cy <= cy1; ++cy) {
+        for (int64_t cx = cx0; cx <= cx1; ++cx) {
+          if (!touches_box(edge.a, edge.b, cx * size, cy * size,
+                           (cx + 1) * size, (cy + 1) * size)) {
+            continue;
+          }
+          hits.emplace_back(static_cast<uint32_t>(cy * ix.cells_x_ + cx), e);
+        }
+      }
+    }
+    std::stable_sort(hits.begin(), hits.end(),
+                     [](const std::pair<uint32_t, uint32_t>& a,
+                        const std::pair<uint32_t, uint32_t>& b) {
+                       return a.first < b.first;
+                     });
+
+    // Boundary entries: the cell's edges plus a reference point off them.
+    for (size_t i = 0; i < hits.size();) {
+      const uint32_t cell = hits[i].first;
+      Entry entry{};
+      entry.fence = f;
+      entry.edge_begin = static_cast<uint32_t>(ix.cell_edges_.size());
+      for (; i < hits.size() && hits[i].first == cell; ++i) {
+        ix.cell_edges_.push_back(hits[i].second);
+      }
+      entry.edge_count =
+          static_cast<uint32_t>(ix.cell_edges_.size()) - entry.edge_begin;
+
+      const int64_t x0 = static_cast<int64_t>(cell % ix.cells_x_) * size;
+      const int64_t y0 = static_cast<int64_t>(cell / ix.cells_x_) * size;
+      const int64_t h = size / 2;
+      const int64_t q = size / 4;
+      const Point candidates[] = {
+          {x0 + h, y0 + h},         {x0 + h + 1, y0 + h},
+          {x0 + h, y0 + h + 1},     {x0 + q, y0 + q + 1},
+          {x0 + h + q, y0 + q + 1}, {x0 + q + 1, y0 + h + q}};
+      Point ref = candidates[0];
+      for (const Point& c : candidates) {
+        bool on_edge = false;
+        for (uint32_t k = 0; k < entry.edge_count && !on_edge; ++k) {
+          const Edge& edge = ix.edges_[ix.cell_edges_[entry.edge_begin + k]];
+          on_edge = on_segment(c, edge.a, edge.b);
+        }
+        ref = c;
+        if (!on_edge) break;
+      }
+      entry.ref_x = static_cast<int32_t>(ref.x);
+      entry.ref_y = static_cast<int32_t>(ref.y);
+      boundary[cell] = f + 1;
+      slot[cell] = static_cast<uint32_t>(placed.size());
+      placed.emplace_back(cell, entry);
+    }
+
+    // Ray-cast reference points and the centres of cells no edge touches
+    // row by row, against just the edges spanning the row's centre line.
+    // Cells without edges are wholly inside or wholly outside.
+    const size_t cx0 = static_cast<size_t>(fx0 / size);
+    const size_t cx1 = static_cast<size_t>(fx1 / size);
+    for (size_t cy = static_cast<size_t>(fy0 / size);
+         cy <= static_cast<size_t>(fy1 / size); ++cy) {
+      const int64_t yc = static_cast<int64_t>(cy) * size + size / 2;
+      row_edges.clear();
+      for (uint32_t e = eb; e < ee; ++e) {
+        if ((ix.edges_[e].a.y > yc) != (ix.edges_[e].b.y > yc)) {
+          row_edges.push_back(e);
+        }
+      }
+      for (size_t cx = cx0; cx <= cx1; ++cx) {
+        const uint32_t cell = static_cast<uint32_t>(cy * ix.cells_x_ + cx);
+        if (boundary[cell] == f + 1) {
+          Entry& entry = placed[slot[cell]].second;
+          const Point ref{entry.ref_x, entry.ref_y};
+          bool inside = false;
+          if (ref.y == yc) {
+            for (uint32_t e : row_edges) {
+              inside ^= ray_crosses(ref, ix.edges_[e].a, ix.edges_[e].b);
+            }
+          } else {
+            for (uint32_t e = eb; e < ee; ++e) {
+              inside ^= ray_crosses(ref, ix.edges_[e].a, ix.edges_[e].b);
+            }
+          }
+          entry.ref_inside = inside;
+          continue;
+        }
+        if (row_edges.empty()) continue;
+        const Point c{static_cast<int64_t>(cx) * size + size / 2, yc};
+        bool inside = false;
+        for (uint32_t e : row_edges) {
+          inside ^= ray_crosses(c, ix.edges_[e].a, ix.edges_[e].b);
+        }
+        if (!inside) continue;
+        Entry entry{};
+        entry.fence = f;
+        entry.ref_inside = 1;
+        placed.emplace_back(cell, entry);
+      }
+    }
+  }
+
+  std::stable_sort(placed.begin(), placed.end(),
+                   [](const std::pair<uint32_t, Entry>& a,
+                      const std::pair<uint32_t, Entry>& b) {
+                     return a.first < b.first;
+                   });
+  ix.cell_begin_.assign(ix.cell_count() + 1, 0);
+  ix.entries_.reserve(placed.size());
+  for (const auto& p : placed) {
+    ++ix.cell_begin_[p.first + 1];
+    ix.entries_.push_back(p.second);
+  }
+  for (size_t c = 0; c < ix.cell_count(); ++c) {
+    ix.cell_begin_[c + 1] += ix.cell_begin_[c];
+  }
+  return Status::kOk;
+}
+
+void FenceIndex::locate(int32_t lat_e7, int32_t lon_e7, uint64_t* mask) const {
+  std::fill(mask, mask + mask_words(), 0);
+  const Point p = to_local(lat_e7, lon_e7);
+  if (p.x < 0 || p.y < 0) return;
+  const uint64_t cx = static_cast<uint64_t>(p.x / cell_size_);
+  const uint64_t cy = static_cast<uint64_t>(p.y / cell_size_);
+  if (cx >= cells_x_ || cy >= cells_y_) return;
+  const size_t cell = cy * cells_x_ + cx;
+  for (uint32_t i = cell_begin_[cell]; i < cell_begin_[cell + 1]; ++i) {
+    const Entry& entry = entries_[i];
+    bool inside = entry.ref_inside;
+    const Point ref{entry.ref_x, entry.ref_y};
+    const uint32_t* edge = &cell_edges_[entry.edge_begin];
+    for (uint32_t k = 0; k < entry.edge_count; ++k) {
+      const Edge& e = edges_[edge[k]];
+      inside ^= crosses(ref, p, e.a, e.b);
+    }
+    if (inside) mask[entry.fence / 64] |= uint64_t{1} << (entry.fence % 64);
+  }
+}
+
+bool FenceIndex::contains_slow(size_t i, int32_t lat_e7,
+                               int32_t lon_e7) const {
+  const Point p = to_local(lat_e7, lon_e7);
+  if (p.x < 0 || p.y < 0 || p.x >= kMaxSpan || p.y >= kMaxSpan) return false;
+  bool inside = false;
+  for (uint32_t e = fence_edge_begin_[i]; e < fence_edge_begin_[i + 1]; ++e) {
+    inside ^= ray_crosses(p, edges_[e].a, edges_[e].b);
+  }
+  return inside;
+}
+
+size_t FenceIndex::memory_bytes() const {
+  return fence_ids_.size() * sizeof(uint32_t) +
+         fence_edge_begin_.size() * sizeof(uint32_t) +
+         edges_.size() * sizeof(Edge) +
+         cell_begin_.size() * sizeof(uint32_t) +
+         entries_.size() * sizeof(Entry) +
+         cell_edges_.size() * sizeof(uint32_t);
+}
+
+}  // namespace server
+}  // namespace ct
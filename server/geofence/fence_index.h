@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/status.h"
+
+namespace ct {
+namespace server {
+
+struct GeoPoint {
+  int32_t lat_e7 = 0;
+  int32_t lon_e7 = 0;
+};
+
+// Polygon, implicitly closed. Containment follows the even-odd rule, so a
+// self-intersecting outline still gives a well-defined answer. A point on
+// an edge or vertex is judged as if moved a hair east (and a far smaller hair
+// north): a square's west and south sides are inside, its east and north
+// sides outside.
+struct Fence {
+  uint32_t id = 0;
+  std::vector<GeoPoint> vertices;
+};
+
+struct FenceIndexOptions {
+  // Target grid cells per polygon edge. More cells mean fewer edges per
+  // boundary cell and a larger index.
+  double cells_per_edge = 2.0;
+  uint32_t max_cells = 1u << 20;
+};
+
+// Set of fences compiled into a uniform grid for point-in-polygon queries.
+//
+// Every cell records, per fence that touches it, either "wholly inside" or a
+// reference point with known inside/outside state plus the fence edges that
+// cross the cell. A query maps the point to its cell and, for boundary
+// entries, flips the reference state once per edge crossed by the segment
+// from the reference point to the query point. That segment never leaves the
+// cell, so only the cell's own edges can cross it and the cost does not grow
+// with the polygon's vertex count. Arithmetic is exact 64-bit integer math on
+// coordinates relative to the grid origin.
+class FenceIndex {
+ public:
+  static Status build(const std::vector<Fence>& fences,
+                      const FenceIndexOptions& options, FenceIndex* out);
+
+  size_t fence_count() const { return fence_ids_.size(); }
+  uint32_t fence_id(size_t i) const { return fence_ids_[i]; }
+  size_t mask_words() const { return (fence_ids_.size() + 63) / 64; }
+
+  // Sets bit i of |mask| (mask_words() words) for every fence i containing
+  // the point, clearing all others.
+  void locate(int32_t lat_e7, int32_t lon_e7, uint64_t* mask) const;
+
+  // Plain ray cast over every edge of fence |i|, for validation.
+  bool contains_slow(size_t i, int32_t lat_e7, int32_t lon_e7) const;
+
+  size_t cell_count() const { return cells_x_ * cells_y_; }
+  size_t memory_bytes() const;
+
+ private:
+  struct Point {
+    int64_t x;
+    int64_t y;
+  };
+  struct Edge {
+    Point a;
+    Point b;
+  };
+  // Fence's status within one cell.
+  struct Entry {
+    uint32_t fence;
+    uint32_t edge_begin;  // into cell_edges_
+    uint32_t edge_count;  // 0: the whole cell is inside the fence
+    int32_t ref_x;  // reference point, off every edge of the cell
+    int32_t ref_y;
+    uint32_t ref_inside;
+  };
+
+  Point to_local(int32_t lat_e7, int32_t lon_e7) const {
+    return {static_cast<int64_t>(lon_e7) - origin_lon_,
+            static_cast<int64_t>(lat_e7) - origin_lat_};
+  }
+
+  std::vector<uint32_t> fence_ids_;
+  std::vector<uint32_t> fence_edge_begin_;  // size fence_count() + 1
+  std::vector<Edge> edges_;
+  int64_t origin_lat_ = 0;
+  int64_t origin_lon_ = 0;
+  int64_t cell_size_ = 1;
+  size_t cells_x_ = 0;
+  size_t cells_y_ = 0;
+  std::vector<uint32_t> cell_begin_;  // size cell_count() + 1, into entries_
+  std::vector<Entry> entries_;
+  std::vector<uint32_t> cell_edges_;  // indices into edges_
+};
+
+}  // namespace server
+}  // namespace ct
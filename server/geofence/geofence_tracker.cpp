@@ -0,0 +1,108 @@
+#include "geofence/geofence_tracker.h"
+
+#include <utility>
+
+namespace ct {
+namespace server {
+
+GeofenceTracker::GeofenceTracker(FenceLookup lookup,
+                                 const GeofencePolicy& policy)
+    : lookup_(std::move(lookup)), policy_(policy) {
+  if (policy_.confirm_fixes == 0) policy_.confirm_fixes = 1;
+}
+
+GeofenceTracker::DeviceState& GeofenceTracker::state_of(uint32_t device_id) {
+  auto it = devices_.find(device_id);
+  if (it != devices_.end()) return it->second;
+  DeviceState& dev = devices_[device_id];
+  dev.index = lookup_ ? lookup_(device_id) : nullptr;
+  if (dev.index) {
+    dev.inside.assign(dev.index->mask_words(), 0);
+    dev.pending.assign(dev.index->mask_words(), 0);
+    dev.count.assign(dev.index->fence_count(), 0);
+  }
+  return dev;
+}
+
+void GeofenceTracker::update(uint32_t device_id, const track::Fix& fix,
+                             std::vector<FenceEvent>* events) {
+  DeviceState& dev = state_of(device_id);
+  if (!dev.index || dev.index->fence_count() == 0) return;
+  if (dev.primed && fix.time_s < dev.last_time_s) {
+    ++stats_.stale;
+    return;
+  }
+  ++stats_.checks;
+  dev.last_time_s = fix.time_s;
+
+  const size_t words = dev.index->mask_words();
+  scratch_.resize(words);
+  dev.index->locate(fix.lat_e7, fix.lon_e7, scratch_.data());
+  if (!dev.primed) {
+    dev.inside = scratch_;
+    dev.primed = true;
+    return;
+  }
+
+  for (size_t w = 0; w < words; ++w) {
+    const uint64_t diff = scratch_[w] ^ dev.inside[w];
+    uint64_t touched = diff | dev.pending[w];
+    while (touched != 0) {
+      const unsigned bit = static_cast<unsigned>(__builtin_ctzll(touched));
+      touched &= touched - 1;
+      const uint64_t m = uint64_t{1} << bit;
+      const size_t f = w * 64 + bit;
+      if (!(diff & m)) {
+        // Back in agreement before the change was confirmed.
+        dev.count[f] = 0;
+        dev.pending[w] &= ~m;
+        continue;
+      }
+      if (++dev.count[f] < policy_.confirm_fixes) {
+        dev.pending[w] |= m;
+        continue;
+      }
+      dev.count[f] = 0;
+      dev.pending[w] &= ~m;
+      dev.inside[w] ^= m;
+      FenceEvent event;
+      event.device_id = device_id;
+      event.fence_id = dev.index->fence_id(f);
+      event.time_s = fix.time_s;
+      event.entered = (dev.inside[w] & m) != 0;
+      events->push_back(event);
+      ++stats_.events;
+    }
+  }
+}
+
+bool GeofenceTracker::inside(uint32_t device_id, uint32_t fence_id) const {
+  auto it = devices_.find(device_id);
+  if (it == devices_.end() || !it->second.index) return false;
+  const DeviceState& dev = it->second;
+  for (size_t f = 0; f < dev.index->fence_count(); ++f) {
+    if (dev.index->fence_id(f) == fence_id) {
+      return (dev.inside[f / 64] >> (f % 64)) & 1;
+    }
+  }
+  return false;
+}
+
+GeofenceSink::GeofenceSink(FenceLookup lookup, const GeofencePolicy& policy,
+                           EventHandler on_events)
+    : tracker_(std::move(lookup), policy), on_events_(std::move(on_events)) {}
+
+void GeofenceSink::consume(uint32_t device_id, const FixBlock& block) {
+  events_.clear();
+  for (uint32_t i = 0; i < block.count; ++i) {
+    track::Fix fix;
+    fix.time_s = block.time_s[i];
+    fix.lat_e7 = block.lat_e7[i];
+    fix.lon_e7 = block.lon_e7[i];
+    tracker_.update(device_id, fix, &events_);
+  }
+  if (!events_.empty() && on_events_) on_events_(events_);
+}
+
+}  // namespace server
+}  // namespace ct
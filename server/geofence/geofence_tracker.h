@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "geofence/fence_index.h"
+#include "ingest/ingest_pipeline.h"
+#include "track/fix.h"
+
+namespace ct {
+namespace server {
+
+struct FenceEvent {
+  uint32_t device_id = 0;
+  uint32_t fence_id = 0;
+  uint32_t time_s = 0;
+  bool entered = false;
+};
+
+struct GeofencePolicy {
+  // Consecutive fixes that must disagree with a fence's state before it
+  // flips. Keeps GPS jitter along a fence line from raising event storms.
+  uint8_t confirm_fixes = 2;
+};
+
+struct GeofenceStats {
+  uint64_t checks = 0;
+  uint64_t stale = 0;  // fixes older than the device's last, ignored
+  uint64_t events = 0;
+};
+
+// Returns a device's compiled fences, or null when it has none. Indexes are
+// immutable and shared, so one fence set can serve many devices.
+using FenceLookup =
+    std::function<std::shared_ptr<const FenceIndex>(uint32_t device_id)>;
+
+// Incremental enter/exit state for many devices.
+//
+// Each device keeps one bit per fence plus a small pending counter, and a
+// fix costs one FenceIndex::locate() and a word-wise diff against the last
+// state. The first fix after a device is (re)loaded only primes the state:
+// nothing is known about where it was before. Not thread-safe; give every
+// ingest worker its own tracker.
+class GeofenceTracker {
+ public:
+  explicit GeofenceTracker(FenceLookup lookup,
+                           const GeofencePolicy& policy = GeofencePolicy());
+
+  // Evaluates one fix and appends resulting transitions to |events|.
+  void update(uint32_t device_id, const track::Fix& fix,
+              std::vector<FenceEvent>* events);
+
+  // Forgets the device, so its fences are looked up again on the next fix.
+  void reload(uint32_t device_id) { devices_.erase(device_id); }
+
+  // Confirmed state of one fence; false for unknown devices or fences.
+  bool inside(uint32_t device_id, uint32_t fence_id) const;
+
+  const GeofenceStats& stats() const { return stats_; }
+
+ private:
+  struct DeviceState {
+    std::shared_ptr<const FenceIndex> index;
+    std::vector<uint64_t> inside;   // confirmed, one bit per fence
+    std::vector<uint64_t> pending;  // fences with a nonzero counter
+    std::vector<uint8_t> count;     // disagreeing fixes so far, per fence
+    uint32_t last_time_s = 0;
+    bool primed = false;
+  };
+
+  DeviceState& state_of(uint32_t device_id);
+
+  FenceLookup lookup_;
+  GeofencePolicy policy_;
+  std::unordered_map<uint32_t, DeviceState> devices_;
+  std::vector<uint64_t> scratch_;
+  GeofenceStats stats_;
+};
+
+// Ingest sink that runs every decoded fix through a GeofenceTracker and
+// hands each block's transitions to |on_events|.
+class GeofenceSink : public IngestSink {
+ public:
+  using EventHandler = std::function<void(const std::vector<FenceEvent>&)>;
+
+  GeofenceSink(FenceLookup lookup, const GeofencePolicy& policy,
+               EventHandler on_events);
+
+  void consume(uint32_t device_id, const FixBlock& block) override;
+
+  const GeofenceTracker& tracker() const { return tracker_; }
+
+ private:
+  GeofenceTracker tracker_;
+  EventHandler on_events_;
+  std::vector<FenceEvent> events_;
+};
+
+}  // namespace server
+}  // namespace ct
@@ -0,0 +1,122 @@
+#include "history/track_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "track/geo.h"
+
+namespace ct {
+namespace server {
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kEarthCircumferenceM = 40075016.686;
+constexpr double kLatScaleM = track::kMetersPerDegree * 1e-7;
+
+// Maps an angle difference to (-pi, pi].
+double wrap(double a) {
+  if (a > kPi) return a - 2.0 * kPi;
+  if (a <= -kPi) return a + 2.0 * kPi;
+  return a;
+}
+
+}  // namespace
+
+double zoom_tolerance_m(int zoom, int32_t lat_e7) {
+  return kEarthCircumferenceM * std::cos(lat_e7 * 1e-7 * kPi / 180.0) /
+         std::ldexp(256.0, zoom);
+}
+
+// A skipped fix may sit up to cone_m_ to the side of the output segment and
+// up to cone_m_ beyond its end, so it is never more than sqrt(2) * cone_m_
+// (the tolerance) away from the segment.
+TrackSimplifier::TrackSimplifier(double tolerance_m)
+    : tolerance_m_(tolerance_m), cone_m_(tolerance_m * std::sqrt(0.5)) {}
+
+void TrackSimplifier::restart(const track::Fix& anchor) {
+  anchor_ = anchor;
+  have_anchor_ = true;
+  have_candidate_ = false;
+  constrained_ = false;
+  lon_scale_ = track::lon_scale_m(anchor.lat_e7);
+  reach_ = 0.0;
+}
+
+bool TrackSimplifier::add(const track::Fix& fix, track::Fix* out) {
+  if (!have_anchor_) {
+    restart(fix);
+    *out = fix;
+    return true;
+  }
+  bool emitted = false;
+  for (;;) {
+    const double dx =
+        static_cast<double>(int64_t{fix.lon_e7} - anchor_.lon_e7) * lon_scale_;
+    const double dy =
+        static_cast<double>(int64_t{fix.lat_e7} - anchor_.lat_e7) * kLatScaleM;
+    const double d = std::sqrt(dx * dx + dy * dy);
+    // Doubling back past the farthest skipped fix leaves it beyond the end of
+    // the segment; heading out of the cone leaves some fix off to its side.
+    bool fits = d >= reach_ - cone_m_;
+    double rel = 0.0;
+    if (fits && d > 0.0) {
+      const double theta = std::atan2(dy, dx);
+      if (!constrained_) base_ = theta;
+      rel = wrap(theta - base_);
+      fits = !constrained_ || (rel >= lo_ && rel <= hi_);
+    }
+    if (fits) {
+      // A fix within tolerance of the anchor is within tolerance of any
+      // segment leaving it, so it narrows nothing. That lets a resting
+      // cat's GPS jitter collapse into one point.
+      if (d > tolerance_m_) {
+        const double alpha = std::asin(cone_m_ / d);
+        lo_ = constrained_ ? std::max(lo_, rel - alpha) : -alpha;
+        hi_ = constrained_ ? std::min(hi_, rel + alpha) : alpha;
+        constrained_ = true;
+        reach_ = std::max(reach_, d);
+      }
+      candidate_ = fix;
+      have_candidate_ = true;
+      return emitted;
+    }
+    // Keep the last fix that fitted and start the next segment from it. A
+    // fresh anchor accepts any fix, so this loops at most once.
+    *out = candidate_;
+    emitted = true;
+    restart(candidate_);
+  }
+}
+
+bool TrackSimplifier::finish(track::Fix* out) {
+  const bool pending = have_anchor_ && have_candidate_;
+  if (pending) *out = candidate_;
+  have_anchor_ = false;
+  have_candidate_ = false;
+  return pending;
+}
+
+ZoomSimplifier::ZoomSimplifier(const std::vector<double>& tolerances_m,
+                               Emit emit)
+    : emit_(std::move(emit)) {
+  levels_.reserve(tolerances_m.size());
+  for (double t : tolerances_m) levels_.emplace_back(t);
+}
+
+void ZoomSimplifier::add(const track::Fix& fix) {
+  track::Fix out;
+  for (size_t i = 0; i < levels_.size(); ++i) {
+    if (levels_[i].add(fix, &out)) emit_(i, out);
+  }
+}
+
+void ZoomSimplifier::finish() {
+  track::Fix out;
+  for (size_t i = 0; i < levels_.size(); ++i) {
+    if (levels_[i].finish(&out)) emit_(i, out);
+  }
+}
+
+}  // namespace server
+}  // namespace ct
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "track/fix.h"
+
+namespace ct {
+namespace server {
+
+// Size of one screen pixel at |zoom| on 256-pixel web map tiles, in meters
+// at latitude |lat_e7|. Simplifying to this tolerance is invisible on screen.
+double zoom_tolerance_m(int zoom, int32_t lat_e7);
+
+// Streaming polyline simplification with a hard error bound.
+//
+// A sleeve-fitting (Zhao-Saalfeld) variant of the opening-window method:
+// from the last kept fix it narrows the cone of directions that keeps every
+// skipped fix within tolerance, and keeps the previous fix as soon as a new
+// one falls outside the cone. Every dropped fix lies within |tolerance_m| of
+// the output polyline, so it guarantees what Douglas-Peucker does, in one
+// O(n) pass with constant state instead of the whole track in memory.
+// Output fixes are input fixes, times included, in input order.
+class TrackSimplifier {
+ public:
+  explicit TrackSimplifier(double tolerance_m);
+
+  // Feeds the next fix in time order. Returns true with the fix in |out|
+  // when a vertex of the simplified track becomes final; at most one per
+  // call. The first fix is always kept.
+  bool add(const track::Fix& fix, track::Fix* out);
+
+  // Ends the track, returning its last fix if not kept yet. The simplifier
+  // is then ready for a new track.
+  bool finish(track::Fix* out);
+
+  double tolerance_m() const { return tolerance_m_; }
+
+ private:
+  void restart(const track::Fix& anchor);
+
+  double tolerance_m_;
+  double cone_m_;  // half-width of the sleeve around the output segment
+  bool have_anchor_ = false;
+  bool have_candidate_ = false;
+  bool constrained_ = false;
+  track::Fix anchor_;
+  track::Fix candidate_;
+  double lon_scale_ = 0.0;  // meters per 1e-7 degree at the anchor
+  double base_ = 0.0;       // direction the cone is measured from
+  double lo_ = 0.0;         // cone, in radians relative to base_
+  double hi_ = 0.0;
+  double reach_ = 0.0;      // farthest skipped fix from the anchor
+};
+
+// Runs one simplifier per zoom tolerance over a single pass of the input,
+// so a stored history is read once to build every level.
+class ZoomSimplifier {
+ public:
+  using Emit = std::function<void(size_t level, const track::Fix& fix)>;
+
+  ZoomSimplifier(const std::vector<double>& tolerances_m, Emit emit);
+
+  void add(const track::Fix& fix);
+  void finish();
+
+  size_t levels() const { return levels_.size(); }
+
+ private:
+  std::vector<TrackSimplifier> levels_;
+  Emit emit_;
+};
+
+}  // namespace server
+}  // namespace ct
@@ -0,0 +1,72 @@
+#include "ingest/fix_decoder.h"
+
+#include <cstring>
+
+#include "common/varint.h"
+
+namespace ct {
+namespace server {
+namespace {
+
+constexpr size_t kMaxFields = 3 * (track::kUplinkMaxFixes - 1);
+constexpr uint64_t kContinuationBits = 0x8080808080808080ull;
+
+// Splits |len| bytes of varints into exactly |want| values.
+Status split_varints(const uint8_t* p, size_t len, uint32_t* out,
+                     size_t want) {
+  size_t pos = 0;
+  size_t n = 0;
+  while (n < want) {
+    if (want - n >= 8 && len - pos >= 8) {
+      uint64_t word;
+      std::memcpy(&word, p + pos, sizeof(word));
+      if ((word & kContinuationBits) == 0) {
+        for (size_t i = 0; i < 8; ++i) out[n + i] = p[pos + i];
+        n += 8;
+        pos += 8;
+        continue;
+      }
+    }
+    const int used = get_varint(p + pos, len - pos, &out[n]);
+    if (used <= 0) return Status::kCorrupt;
+    pos += static_cast<size_t>(used);
+    ++n;
+  }
+  return pos == len ? Status::kOk : Status::kCorrupt;
+}
+
+}  // namespace
+
+Status decode_fixes(const FrameView& view, FixBlock* block) {
+  const size_t records = view.count - 1u;
+  const size_t fields = 3 * records;
+  uint32_t raw[kMaxFields];
+  CT_RETURN_IF_ERROR(split_varints(view.body, view.body_len, raw, fields));
+
+  // Zigzag over every field. The dt results are never read, but a uniform
+  // stride-1 loop is what the compiler turns into SIMD.
+  int32_t delta[kMaxFields];
+  for (size_t i = 0; i < fields; ++i) {
+    delta[i] = static_cast<int32_t>((raw[i] >> 1) ^ (0u - (raw[i] & 1u)));
+  }
+
+  uint32_t t = view.first.time_s;
+  uint32_t lat = static_cast<uint32_t>(view.first.lat_e7);
+  uint32_t lon = static_cast<uint32_t>(view.first.lon_e7);
+  block->time_s[0] = t;
+  block->lat_e7[0] = view.first.lat_e7;
+  block->lon_e7[0] = view.first.lon_e7;
+  for (size_t i = 0; i < records; ++i) {
+    t += raw[3 * i];
+    lat += static_cast<uint32_t>(delta[3 * i + 1]);
+    lon += static_cast<uint32_t>(delta[3 * i + 2]);
+    block->time_s[i + 1] = t;
+    block->lat_e7[i + 1] = static_cast<int32_t>(lat);
+    block->lon_e7[i + 1] = static_cast<int32_t>(lon);
+  }
+  block->count = view.count;
+  return Status::kOk;
+}
+
+}  // namespace server
+}  // namespace ct
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+#include "ingest/frame_view.h"
+#include "track/uplink_frame.h"
+
+namespace ct {
+namespace server {
+
+// Fixes of one frame in column (structure-of-arrays) form. Fixed capacity,
+// so decoding never allocates and blocks can live on a worker's stack.
+struct FixBlock {
+  uint32_t count = 0;
+  uint32_t time_s[track::kUplinkMaxFixes];
+  int32_t lat_e7[track::kUplinkMaxFixes];
+  int32_t lon_e7[track::kUplinkMaxFixes];
+};
+
+// Decodes all fixes of |view| into |block|.
+//
+// Three passes instead of one fused loop: varints are split into a flat
+// array (taking eight single-byte varints at a time when a word has no
+// continuation bits), zigzag decoding then runs as a branch-free loop the
+// compiler vectorizes, and a final scan turns deltas into absolute columns.
+Status decode_fixes(const FrameView& view, FixBlock* block);
+
+}  // namespace server
+}  // namespace ct
@@ -0,0 +1,59 @@
+#include "ingest/frame_view.h"
+
+#include <cstring>
+
+#include "common/byte_io.h"
+#include "common/crc32.h"
+#include "track/uplink_frame.h"
+
+namespace ct {
+namespace server {
+
+Status parse_frame(const uint8_t* frame, size_t len, FrameView* view) {
+  if (len < track::kUplinkHeaderSize + track::kUplinkTrailerSize ||
+      frame[0] != track::kUplinkVersion) {
+    return Status::kCorrupt;
+  }
+  const size_t body_end = len - track::kUplinkTrailerSize;
+  if (get_u32(frame + body_end) != crc32(frame, body_end)) {
+    return Status::kCrcMismatch;
+  }
+  view->device_id = get_u32(frame + 1);
+  view->seq = get_u16(frame + 5);
+  view->count = frame[7];
+  if (view->count == 0) return Status::kCorrupt;
+  view->first.time_s = get_u32(frame + 8);
+  view->first.lat_e7 = static_cast<int32_t>(get_u32(frame + 12));
+  view->first.lon_e7 = static_cast<int32_t>(get_u32(frame + 16));
+  view->body = frame + track::kUplinkHeaderSize;
+  view->body_len = body_end - track::kUplinkHeaderSize;
+  return Status::kOk;
+}
+
+bool FrameCursor::next(const uint8_t** frame, size_t* len) {
+  if (pos_ == len_) return false;
+  if (len_ - pos_ < 2) {
+    truncated_ = true;
+    return false;
+  }
+  const size_t n = get_u16(buf_ + pos_);
+  if (len_ - pos_ - 2 < n) {
+    truncated_ = true;
+    return false;
+  }
+  *frame = buf_ + pos_ + 2;
+  *len = n;
+  pos_ += 2 + n;
+  return true;
+}
+
+size_t append_framed(const uint8_t* frame, size_t len, uint8_t* out,
+                     size_t cap) {
+  if (len > 0xFFFF || cap < len + 2) return 0;
+  put_u16(out, static_cast<uint16_t>(len));
+  std::memcpy(out + 2, frame, len);
+  return len + 2;
+}
+
+}  // namespace server
+}  // namespace ct
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/status.h"
+#include "track/fix.h"
+
+namespace ct {
+namespace server {
+
+// Parsed header of one uplink frame (firmware/track/uplink_frame.h) that
+// still points into the receive buffer. Nothing is copied; the view is valid
+// as long as the buffer is.
+struct FrameView {
+  uint32_t device_id = 0;
+  uint16_t seq = 0;
+  uint8_t count = 0;
+  track::Fix first;
+  const uint8_t* body = nullptr;  // delta records after the first fix
+  size_t body_len = 0;
+};
+
+// Validates version, length and CRC and fills |view|.
+Status parse_frame(const uint8_t* frame, size_t len, FrameView* view);
+
+// Reads only the device id, for routing before full parsing.
+inline bool peek_device_id(const uint8_t* frame, size_t len, uint32_t* id) {
+  if (len < 5) return false;
+  *id = static_cast<uint32_t>(frame[1]) |
+        (static_cast<uint32_t>(frame[2]) << 8) |
+        (static_cast<uint32_t>(frame[3]) << 16) |
+        (static_cast<uint32_t>(frame[4]) << 24);
+  return true;
+}
+
+// Walks a gateway receive buffer: frames back to back, each prefixed with
+// its length as a little-endian u16.
+class FrameCursor {
+ public:
+  FrameCursor(const uint8_t* buf, size_t len) : buf_(buf), len_(len) {}
+
+  // Returns false at the end of the buffer. A truncated trailing frame ends
+  // the walk and is reported by truncated().
+  bool next(const uint8_t** frame, size_t* len);
+  bool truncated() const { return truncated_; }
+  size_t offset() const { return pos_; }
+
+ private:
+  const uint8_t* buf_;
+  size_t len_;
+  size_t pos_ = 0;
+  bool truncated_ = false;
+};
+
+// Appends |frame| to a receive buffer in FrameCursor's layout. Returns the
+// bytes written, 0 if |cap| is too small.
+size_t append_framed(const uint8_t* frame, size_t len, uint8_t* out,
+                     size_t cap);
+
+}  // namespace server
+}  // namespace ct
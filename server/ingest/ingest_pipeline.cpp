@@ -0,0 +1,130 @@
+#include "ingest/ingest_pipeline.h"
+
+namespace ct {
+namespace server {
+
+IngestStats& IngestStats::operator+=(const IngestStats& o) {
+  buffers += o.buffers;
+  frames += o.frames;
+  fixes += o.fixes;
+  duplicates += o.duplicates;
+  corrupt += o.corrupt;
+  truncated_buffers += o.truncated_buffers;
+  return *this;
+}
+
+IngestPipeline::IngestPipeline(const IngestConfig& config,
+                               SinkFactory make_sink)
+    : config_(config) {
+  const unsigned n = config_.workers == 0 ? 1 : config_.workers;
+  for (unsigned i = 0; i < n; ++i) {
+    auto shard = std::make_unique<Shard>();
+    shard->sink = make_sink(i);
+    shards_.push_back(std::move(shard));
+  }
+  for (auto& shard : shards_) {
+    Shard* s = shard.get();
+    s->thread = std::thread([this, s] { run(s); });
+  }
+}
+
+IngestPipeline::~IngestPipeline() { finish(); }
+
+unsigned IngestPipeline::shard_of(uint32_t device_id, unsigned shards) {
+  // Multiplicative hash so sequential device ids spread evenly.
+  return static_cast<unsigned>(
+      (static_cast<uint64_t>(device_id * 0x9E3779B1u) * shards) >> 32);
+}
+
+void IngestPipeline::submit(ReceiveBuffer buffer) {
+  const unsigned n = workers();
+  std::vector<Batch> batches(n);
+  FrameCursor cursor(buffer->data(), buffer->size());
+  const uint8_t* frame = nullptr;
+  size_t len = 0;
+  while (cursor.next(&frame, &len)) {
+    uint32_t device_id = 0;
+    if (!peek_device_id(frame, len, &device_id)) {
+      ++router_stats_.corrupt;
+      continue;
+    }
+    FrameRef ref;
+    ref.offset = static_cast<uint32_t>(frame - buffer->data());
+    ref.len = static_cast<uint16_t>(len);
+    batches[shard_of(device_id, n)].frames.push_back(ref);
+  }
+  ++router_stats_.buffers;
+  if (cursor.truncated()) ++router_stats_.truncated_buffers;
+
+  for (unsigned i = 0; i < n; ++i) {
+    if (batches[i].frames.empty()) continue;
+    batches[i].buffer = buffer;
+    Shard* s = shards_[i].get();
+    std::unique_lock<std::mutex> lock(s->mu);
+    s->cv.wait(lock, [&] { return s->queue.size() < config_.queue_depth; });
+    s->queue.push_back(std::move(batches[i]));
+    lock.unlock();
+    s->cv.notify_all();
+  }
+}
+
+void IngestPipeline::run(Shard* shard) {
+  while (true) {
+    Batch batch;
+    {
+      std::unique_lock<std::mutex> lock(shard->mu);
+      shard->cv.wait(lock,
+                     [&] { return shard->closed || !shard->queue.empty(); });
+      if (shard->queue.empty()) return;
+      batch = std::move(shard->queue.front());
+      shard->queue.pop_front();
+    }
+    shard->cv.notify_all();
+    process(shard, batch);
+  }
+}
+
+void IngestPipeline::process(Shard* shard, const Batch& batch) {
+  const uint8_t* base = batch.buffer->data();
+  FixBlock block;
+  for (const FrameRef& ref : batch.frames) {
+    FrameView view;
+    if (!is_ok(parse_frame(base + ref.offset, ref.len, &view)) ||
+        !is_ok(decode_fixes(view, &block))) {
+      ++shard->stats.corrupt;
+      continue;
+    }
+    // Devices resend a frame whose ack was lost; the sequence number lets
+    // the retry be dropped here instead of duplicating fixes downstream.
+    DeviceState& dev = shard->devices[view.device_id];
+    if (dev.seen && dev.last_seq == view.seq) {
+      ++shard->stats.duplicates;
+      continue;
+    }
+    dev.seen = true;
+    dev.last_seq = view.seq;
+    ++shard->stats.frames;
+    shard->stats.fixes += block.count;
+    if (shard->sink) shard->sink->consume(view.device_id, block);
+  }
+}
+
+IngestStats IngestPipeline::finish() {
+  if (!finished_) {
+    finished_ = true;
+    for (auto& shard : shards_) {
+      {
+        std::lock_guard<std::mutex> lock(shard->mu);
+        shard->closed = true;
+      }
+      shard->cv.notify_all();
+    }
+    for (auto& shard : shards_) shard->thread.join();
+  }
+  IngestStats total = router_stats_;
+  for (auto& shard : shards_) total += shard->stats;
+  return total;
+}
+
+}  // namespace server
+}  // namespace ct
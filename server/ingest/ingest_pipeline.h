@@ -0,0 +1,105 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ingest/fix_decoder.h"
+
+namespace ct {
+namespace server {
+
+// Receives decoded fixes. Each worker owns its sink, so implementations need
+// no locking; all frames of a device reach the same sink in arrival order.
+class IngestSink {
+ public:
+  virtual ~IngestSink() = default;
+  virtual void consume(uint32_t device_id, const FixBlock& block) = 0;
+};
+
+struct IngestStats {
+  uint64_t buffers = 0;
+  uint64_t frames = 0;
+  uint64_t fixes = 0;
+  uint64_t duplicates = 0;
+  uint64_t corrupt = 0;
+  uint64_t truncated_buffers = 0;
+
+  IngestStats& operator+=(const IngestStats& o);
+};
+
+struct IngestConfig {
+  unsigned workers = 1;
+  // Batches a worker may have queued before submit() blocks.
+  size_t queue_depth = 64;
+};
+
+using ReceiveBuffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+// Multi-threaded ingest stage.
+//
+// submit() walks a receive buffer once, reading only each frame's device id,
+// and hands every worker one batch of (offset, length) references into the
+// shared buffer. Workers own disjoint device-id shards, so per-device state
+// (sequence tracking, last fix) is touched by a single thread without locks,
+// and frame bytes are never copied between threads.
+class IngestPipeline {
+ public:
+  using SinkFactory = std::function<std::unique_ptr<IngestSink>(unsigned)>;
+
+  IngestPipeline(const IngestConfig& config, SinkFactory make_sink);
+  ~IngestPipeline();
+  IngestPipeline(const IngestPipeline&) = delete;
+  IngestPipeline& operator=(const IngestPipeline&) = delete;
+
+  // Routes the frames of |buffer| to the workers. Called from one thread.
+  void submit(ReceiveBuffer buffer);
+
+  // Drains all queues, stops the workers and returns the merged counters.
+  IngestStats finish();
+
+  unsigned workers() const { return static_cast<unsigned>(shards_.size()); }
+  static unsigned shard_of(uint32_t device_id, unsigned shards);
+
+ private:
+  struct FrameRef {
+    uint32_t offset;
+    uint16_t len;
+  };
+  struct Batch {
+    ReceiveBuffer buffer;
+    std::vector<FrameRef> frames;
+  };
+  struct DeviceState {
+    uint16_t last_seq = 0;
+    bool seen = false;
+  };
+  struct Shard {
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<Batch> queue;
+    bool closed = false;
+    std::unique_ptr<IngestSink> sink;
+    std::unordered_map<uint32_t, DeviceState> devices;
+    IngestStats stats;
+    std::thread thread;
+  };
+
+  void run(Shard* shard);
+  void process(Shard* shard, const Batch& batch);
+
+  IngestConfig config_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  IngestStats router_stats_;
+  bool finished_ = false;
+};
+
+}  // namespace server
+}  // namespace ct
@@ -0,0 +1,105 @@
+#include "loadgen/load_generator.h"
+
+#include <random>
+
+#include "ingest/frame_view.h"
+#include "track/uplink_batcher.h"
+
+namespace ct {
+namespace server {
+namespace {
+
+using Frame = std::vector<uint8_t>;
+
+std::vector<Frame> device_frames(uint32_t device_id, const LoadConfig& config,
+                                 Load* load) {
+  const std::vector<track::Fix> fixes = device_track(device_id, config);
+
+  std::vector<Frame> frames;
+  track::UplinkBatcher batcher(device_id, track::BatchPolicy());
+  uint8_t buf[track::kUplinkMaxFrameSize];
+  auto take = [&] {
+    const size_t len = batcher.take_frame(buf);
+    if (len > 0) frames.emplace_back(buf, buf + len);
+  };
+  for (const track::Fix& fix : fixes) {
+    if (batcher.due(fix.time_s)) take();
+    bool full = false;
+    batcher.add(fix, &full);
+    if (full) take();
+    load->checksum +=
+        fix_checksum(device_id, fix.time_s, fix.lat_e7, fix.lon_e7);
+  }
+  take();
+  load->fixes += fixes.size();
+  load->frames += frames.size();
+  return frames;
+}
+
+}  // namespace
+
+sim::TrackModel device_model(uint32_t device_id, const LoadConfig& config) {
+  sim::TrackModel model;
+  model.interval_s = config.interval_s;
+  // Scatter homes over roughly 1 x 1 degree.
+  model.home_lat_e7 +=
+      static_cast<int32_t>((device_id * 7919u) % 10000) * 1000;
+  model.home_lon_e7 +=
+      static_cast<int32_t>((device_id * 104729u) % 10000) * 1000;
+  return model;
+}
+
+std::vector<track::Fix> device_track(uint32_t device_id,
+                                     const LoadConfig& config) {
+  return sim::make_cat_track(config.fixes_per_device,
+                             config.seed * 1000003u + device_id,
+                             device_model(device_id, config));
+}
+
+Load generate_load(const LoadConfig& config) {
+  Load load;
+  std::vector<std::vector<Frame>> per_device(config.devices);
+  for (uint32_t d = 0; d < config.devices; ++d) {
+    per_device[d] = device_frames(d + 1, config, &load);
+  }
+
+  std::mt19937 rng(config.seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  buffer->reserve(config.buffer_bytes);
+  auto emit = [&](const Frame& frame) {
+    if (buffer->size() + frame.size() + 2 > config.buffer_bytes) {
+      load.bytes += buffer->size();
+      load.buffers.push_back(std::move(buffer));
+      buffer = std::make_shared<std::vector<uint8_t>>();
+      buffer->reserve(config.buffer_bytes);
+    }
+    const size_t at = buffer->size();
+    buffer->resize(at + frame.size() + 2);
+    append_framed(frame.data(), frame.size(), buffer->data() + at,
+                  frame.size() + 2);
+  };
+
+  // Round-robin over devices approximates the arrival order at a gateway.
+  for (size_t round = 0;; ++round) {
+    bool any = false;
+    for (const auto& frames : per_device) {
+      if (round >= frames.size()) continue;
+      any = true;
+      emit(frames[round]);
+      if (unit(rng) < config.duplicate_rate) {
+        emit(frames[round]);
+        ++load.duplicates;
+      }
+    }
+    if (!any) break;
+  }
+  if (!buffer->empty()) {
+    load.bytes += buffer->size();
+    load.buffers.push_back(std::move(buffer));
+  }
+  return load;
+}
+
+}  // namespace server
+}  // namespace ct
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ingest/ingest_pipeline.h"
+#include "sim/synthetic_track.h"
+#include "track/fix.h"
+
+namespace ct {
+namespace server {
+
+struct LoadConfig {
+  uint32_t devices = 10000;
+  uint32_t fixes_per_device = 500;
+  uint32_t interval_s = 30;
+  size_t buffer_bytes = 64 * 1024;
+  // Share of frames that are sent twice, as after a lost ack.
+  double duplicate_rate = 0.01;
+  uint32_t seed = 1;
+};
+
+struct Load {
+  std::vector<ReceiveBuffer> buffers;
+  uint64_t bytes = 0;
+  uint64_t frames = 0;  // unique frames
+  uint64_t fixes = 0;
+  uint64_t duplicates = 0;
+  uint64_t checksum = 0;  // sum of fix_checksum() over all unique fixes
+};
+
+// Order-independent per-fix hash, so sinks on different workers can each
+// sum their share and the totals still compare against the generator's.
+inline uint64_t fix_checksum(uint32_t device_id, uint32_t time_s,
+                             int32_t lat_e7, int32_t lon_e7) {
+  uint64_t h = (static_cast<uint64_t>(device_id) << 32) ^ time_s;
+  h ^= static_cast<uint32_t>(lat_e7) * 0x9E3779B97F4A7C15ull;
+  h ^= static_cast<uint32_t>(lon_e7) * 0xC2B2AE3D27D4EB4Full;
+  return h * 0x165667B19E3779F9ull;
+}
+
+// Synthesizes traffic from many trackers: every device runs the real
+// firmware batcher over its own synthetic track, and the resulting frames are
+// interleaved across devices into gateway receive buffers.
+Load generate_load(const LoadConfig& config);
+
+// Track model and fixes of device |device_id| (1..devices) in the load, for
+// checks that replay its traffic without going through the frames.
+sim::TrackModel device_model(uint32_t device_id, const LoadConfig& config);
+std::vector<track::Fix> device_track(uint32_t device_id,
+                                     const LoadConfig& config);
+
+}  // namespace server
+}  // namespace ct
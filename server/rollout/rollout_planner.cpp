@@ -0,0 +1,206 @@
+#include "rollout/rollout_planner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace ct {
+namespace server {
+namespace {
+
+// Position of a device in [0, 1) for cohort assignment: a 32-bit finalizer
+// (murmur3 fmix) so consecutive ids land far apart.
+double cohort_point(uint32_t device_id) {
+  uint32_t h = device_id;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h * (1.0 / 4294967296.0);
+}
+
+}  // namespace
+
+RolloutPlanner::RolloutPlanner(const std::vector<RolloutDevice>& fleet,
+                               const RolloutPolicy& policy)
+    : policy_(policy) {
+  if (policy_.stages.empty()) policy_.stages.push_back(1.0);
+  if (policy_.stages.size() > 255) policy_.stages.resize(255);
+  policy_.stages.back() = 1.0;
+  if (policy_.per_gateway == 0) policy_.per_gateway = 1;
+  if (policy_.max_attempts == 0) policy_.max_attempts = 1;
+
+  std::unordered_map<uint32_t, uint32_t> gateway_index;
+  devices_.resize(fleet.size());
+  for (size_t i = 0; i < fleet.size(); ++i) {
+    Device& dev = devices_[i];
+    dev.device_id = fleet[i].device_id;
+    auto it = gateway_index.find(fleet[i].gateway_id);
+    if (it == gateway_index.end()) {
+      it = gateway_index
+               .emplace(fleet[i].gateway_id,
+                        static_cast<uint32_t>(gateways_.size()))
+               .first;
+      gateways_.emplace_back();
+      gateways_.back().gateway_id = fleet[i].gateway_id;
+    }
+    dev.gateway = it->second;
+    const double u = cohort_point(dev.device_id);
+    while (dev.stage + 1u < policy_.stages.size() &&
+           u >= policy_.stages[dev.stage]) {
+      ++dev.stage;
+    }
+  }
+
+  // Counting sort by (stage, gateway).
+  const size_t gateways = gateways_.size();
+  slices_.assign(policy_.stages.size() * gateways + 1, 0);
+  for (const Device& dev : devices_) {
+    ++slices_[dev.stage * gateways + dev.gateway + 1];
+  }
+  for (size_t k = 1; k < slices_.size(); ++k) slices_[k] += slices_[k - 1];
+  std::vector<uint32_t> fill(slices_.begin(), slices_.end() - 1);
+  order_.resize(devices_.size());
+  for (size_t i = 0; i < devices_.size(); ++i) {
+    const Device& dev = devices_[i];
+    order_[fill[dev.stage * gateways + dev.gateway]++] =
+        static_cast<uint32_t>(i);
+  }
+  start_stage(0);
+}
+
+uint32_t RolloutPlanner::stage_size(size_t stage) const {
+  if (stage >= policy_.stages.size()) return 0;
+  const size_t gateways = gateways_.size();
+  return slices_[(stage + 1) * gateways] - slices_[stage * gateways];
+}
+
+void RolloutPlanner::start_stage(size_t stage) {
+  stage_ = stage;
+  stage_open_ = stage_size(stage);
+  attempts_ = outcomes_ = failures_ = 0;
+  const size_t gateways = gateways_.size();
+  for (uint32_t g = 0; g < gateways; ++g) {
+    Gateway& gw = gateways_[g];
+    gw.next = slices_[stage * gateways + g];
+    gw.end = slices_[stage * gateways + g + 1];
+    if (gw.backlog() > 0) mark_ready(g);
+  }
+}
+
+void RolloutPlanner::advance(double now_s) {
+  for (;;) {
+    if (state_ == RolloutState::kSoaking) {
+      if (now_s < soak_until_s_) return;
+      start_stage(stage_ + 1);
+      state_ = RolloutState::kRunning;
+      continue;
+    }
+    if (state_ != RolloutState::kRunning || stage_open_ > 0) return;
+    if (stage_ + 1 == policy_.stages.size()) {
+      state_ = RolloutState::kDone;
+      return;
+    }
+    if (stage_size(stage_) == 0) {
+      // Nothing was updated, so there is nothing to soak.
+      start_stage(stage_ + 1);
+      continue;
+    }
+    state_ = RolloutState::kSoaking;
+    soak_until_s_ = now_s + policy_.soak_s;
+  }
+}
+
+void RolloutPlanner::mark_ready(uint32_t gateway) {
+  ready_.emplace(gateways_[gateway].backlog(), gateway);
+}
+
+void RolloutPlanner::poll(double now_s, std::vector<RolloutTransfer>* out) {
+  advance(now_s);
+  if (state_ != RolloutState::kRunning) return;
+  while (!ready_.empty()) {
+    if (policy_.max_active != 0 && stats_.active >= policy_.max_active) break;
+    const auto [backlog, g] = ready_.top();
+    ready_.pop();
+    Gateway& gw = gateways_[g];
+    if (gw.active >= policy_.per_gateway || gw.backlog() != backlog ||
+        backlog == 0) {
+      continue;
+    }
+    uint32_t index;
+    if (gw.next < gw.end) {
+      index = order_[gw.next++];
+    } else {
+      index = gw.retry.back();
+      gw.retry.pop_back();
+    }
+    Device& dev = devices_[index];
+    dev.state = DeviceState::kActive;
+    ++dev.attempts;
+    ++gw.active;
+    ++stats_.started;
+    ++attempts_;
+    stats_.peak_active = std::max(stats_.peak_active, ++stats_.active);
+    RolloutTransfer transfer;
+    transfer.handle = index;
+    transfer.device_id = dev.device_id;
+    transfer.gateway_id = gw.gateway_id;
+    transfer.attempt = dev.attempts;
+    out->push_back(transfer);
+    if (gw.backlog() > 0 && gw.active < policy_.per_gateway) mark_ready(g);
+  }
+}
+
+void RolloutPlanner::record_outcome(bool failed) {
+  ++outcomes_;
+  if (failed) ++failures_;
+  if (state_ == RolloutState::kRunning && outcomes_ >= policy_.min_outcomes &&
+      failures_ > policy_.pause_failure_rate * attempts_) {
+    state_ = RolloutState::kPaused;
+    ++stats_.pauses;
+  }
+}
+
+void RolloutPlanner::report(uint32_t handle, bool confirmed) {
+  if (handle >= devices_.size()) return;
+  Device& dev = devices_[handle];
+  if (dev.state != DeviceState::kActive) return;
+  Gateway& gw = gateways_[dev.gateway];
+  --gw.active;
+  --stats_.active;
+  record_outcome(!confirmed);
+  if (confirmed) {
+    dev.state = DeviceState::kConfirmed;
+    ++stats_.confirmed;
+    --stage_open_;
+  } else if (dev.attempts < policy_.max_attempts) {
+    dev.state = DeviceState::kWaiting;
+    gw.retry.push_back(handle);
+    ++stats_.retries;
+  } else {
+    dev.state = DeviceState::kFailed;
+    ++stats_.failed;
+    --stage_open_;
+  }
+  if (gw.backlog() > 0) mark_ready(dev.gateway);
+}
+
+void RolloutPlanner::resume() {
+  if (state_ != RolloutState::kPaused) return;
+  // Attempts still in flight stay counted so their outcomes have a place.
+  attempts_ = stats_.active;
+  outcomes_ = failures_ = 0;
+  state_ = RolloutState::kRunning;
+}
+
+double RolloutPlanner::next_wakeup_s() const {
+  return state_ == RolloutState::kSoaking ? soak_until_s_ : INFINITY;
+}
+
+double RolloutPlanner::failure_rate() const {
+  return attempts_ == 0 ? 0.0 : double(failures_) / attempts_;
+}
+
+}  // namespace server
+}  // namespace ct
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace ct {
+namespace server {
+
+struct RolloutDevice {
+  uint32_t device_id = 0;
+  uint32_t gateway_id = 0;  // gateway the device is normally reached through
+};
+
+struct RolloutPolicy {
+  // Cumulative share of the fleet updated by the end of each stage. A
+  // device's stage comes from a hash of its id, so cohorts are spread over
+  // all gateways and stay the same if the plan is rebuilt.
+  std::vector<double> stages = {0.01, 0.05, 0.25, 1.0};
+  // Concurrent transfers per gateway; size it from the gateway's OTA
+  // bandwidth budget over the per-transfer rate.
+  uint32_t per_gateway = 4;
+  // Concurrent transfers over the whole fleet (backend egress); 0 = none.
+  uint32_t max_active = 0;
+  // Attempts per device before it is given up on for this rollout.
+  uint8_t max_attempts = 3;
+  // Time a finished stage runs in the field before the next one starts.
+  double soak_s = 1800.0;
+  // Pauses the rollout when the failed share of the stage's attempts goes
+  // above this, once at least |min_outcomes| of them have finished.
+  double pause_failure_rate = 0.1;
+  uint32_t min_outcomes = 20;
+};
+
+enum class RolloutState : uint8_t {
+  kRunning = 0,
+  kSoaking = 1,  // stage finished, waiting for soak_s to pass
+  kPaused = 2,   // failure rate tripped; waits for resume()
+  kDone = 3,
+};
+
+struct RolloutTransfer {
+  uint32_t handle = 0;  // index into the fleet; pass back to report()
+  uint32_t device_id = 0;
+  uint32_t gateway_id = 0;
+  uint8_t attempt = 0;  // 1 for the first try
+};
+
+struct RolloutStats {
+  uint64_t started = 0;
+  uint64_t confirmed = 0;
+  uint64_t failed = 0;   // devices out of attempts
+  uint64_t retries = 0;  // failed attempts put back in the queue
+  uint64_t pauses = 0;
+  uint32_t active = 0;
+  uint32_t peak_active = 0;
+};
+
+// Server-side plan for pushing one image to a fleet.
+//
+// Devices are split into staged cohorts; a stage starts only after the one
+// before it has finished and soaked. Within a stage each gateway works
+// through its own queue with at most per_gateway transfers in flight, and
+// when max_active binds, freed capacity goes to the gateway with the most
+// work left, since that one bounds the stage's length. Crossing the failure
+// threshold pauses the rollout, letting transfers in flight finish but
+// starting none until resume(). The rate is over every attempt the stage has
+// started, finished or not: failures end a transfer early, so counting only
+// finished ones would overstate the rate while a stage ramps up.
+//
+// The planner keeps no clock: the caller reports outcomes, then calls
+// poll() to collect the transfers that may start, and calls it again at
+// next_wakeup_s() when a soak ends with nothing else happening.
+class RolloutPlanner {
+ public:
+  RolloutPlanner(const std::vector<RolloutDevice>& fleet,
+                 const RolloutPolicy& policy = RolloutPolicy());
+
+  // Appends every transfer the caps allow to start at |now_s| to |out|.
+  void poll(double now_s, std::vector<RolloutTransfer>* out);
+
+  // Outcome of a transfer from poll(): confirmed on the device, or failed
+  // (dropped, timed out, or rolled back). Unknown handles are ignored.
+  void report(uint32_t handle, bool confirmed);
+
+  // Operator override after a pause; the failure count starts afresh.
+  void resume();
+
+  // When poll() next has work without another report; infinity if never.
+  double next_wakeup_s() const;
+
+  RolloutState state() const { return state_; }
+  size_t stage() const { return stage_; }
+  size_t stage_count() const { return policy_.stages.size(); }
+  size_t device_count() const { return devices_.size(); }
+  size_t gateway_count() const { return gateways_.size(); }
+  uint32_t stage_size(size_t stage) const;
+  double failure_rate() const;
+  const RolloutStats& stats() const { return stats_; }
+
+ private:
+  enum class DeviceState : uint8_t { kWaiting, kActive, kConfirmed, kFailed };
+
+  struct Device {
+    uint32_t device_id = 0;
+    uint32_t gateway = 0;  // index into gateways_
+    uint8_t stage = 0;
+    uint8_t attempts = 0;
+    DeviceState state = DeviceState::kWaiting;
+  };
+
+  struct Gateway {
+    uint32_t gateway_id = 0;
+    uint32_t next = 0;  // cursor into order_ for the current stage
+    uint32_t end = 0;
+    std::vector<uint32_t> retry;  // failed devices waiting for another try
+    uint32_t active = 0;
+
+    uint32_t backlog() const {
+      return end - next + static_cast<uint32_t>(retry.size());
+    }
+  };
+
+  void start_stage(size_t stage);
+  void advance(double now_s);
+  void mark_ready(uint32_t gateway);
+  void record_outcome(bool failed);
+
+  RolloutPolicy policy_;
+  std::vector<Device> devices_;
+  std::vector<Gateway> gateways_;
+  // Device indices grouped by stage, then gateway; slices_ holds the
+  // boundaries, stage-major.
+  std::vector<uint32_t> order_;
+  std::vector<uint32_t> slices_;
+  // Gateways that may have a free slot and queued devices, keyed by backlog.
+  // Entries go stale as gateways change and are checked when popped.
+  std::priority_queue<std::pair<uint32_t, uint32_t>> ready_;
+
+  RolloutState state_ = RolloutState::kRunning;
+  size_t stage_ = 0;
+  uint32_t stage_open_ = 0;  // devices of the stage not yet settled
+  double soak_until_s_ = 0.0;
+
+  // Attempts of the current stage since it started or was resumed.
+  uint32_t attempts_ = 0;
+  uint32_t outcomes_ = 0;
+  uint32_t failures_ = 0;
+
+  RolloutStats stats_;
+};
+
+}  // namespace server
+}  // namespace ct
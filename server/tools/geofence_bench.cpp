@@ -0,0 +1,338 @@
+// Measures geofence checks per second as fence count and polygon size grow.
+//
+//   geofence_bench [--fences=1,4,16,64] [--vertices=8,64,512,4096]
+//                  [--fixes=N] [--sink_devices=N] [--seed=N]
+//
+// Fences are random star-shaped polygons scattered over a synthetic cat's
+// roaming area and the query points are that cat's fixes. Every indexed
+// answer is compared with a brute-force ray cast (bounding box test, then
+// every edge of every fence), which is also timed as the baseline. So are
+// points exactly on fence vertices and edges, checked against their own
+// fence, and a square whose corners and sides pin the boundary rule down.
+//
+// Last, --sink_devices devices' frames from the load generator run through
+// IngestPipeline into GeofenceSink, and the events must match a
+// GeofenceTracker fed each device's track directly.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "geofence/fence_index.h"
+#include "geofence/geofence_tracker.h"
+#include "ingest/ingest_pipeline.h"
+#include "loadgen/load_generator.h"
+#include "sim/flags.h"
+#include "sim/synthetic_track.h"
+#include "track/geo.h"
+
+using namespace ct;
+
+namespace {
+
+// Brute force only sees enough points to spend about this many edge tests.
+constexpr double kBruteEdgeBudget = 2e8;
+
+std::vector<uint32_t> parse_list(const std::string& text) {
+  std::vector<uint32_t> out;
+  std::stringstream list(text);
+  for (std::string item; std::getline(list, item, ',');) {
+    if (!item.empty()) out.push_back(static_cast<uint32_t>(std::stoul(item)));
+  }
+  return out;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+std::vector<server::Fence> make_fences(uint32_t count, uint32_t vertices,
+                                       uint32_t seed,
+                                       const sim::TrackModel& model) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  const double lat_per_m = 1e7 / track::kMetersPerDegree;
+  const double lon_per_m = 1.0 / track::lon_scale_m(model.home_lat_e7);
+  std::vector<server::Fence> fences(count);
+  for (uint32_t f = 0; f < count; ++f) {
+    const double dist = model.roam_radius_m * std::sqrt(unit(rng));
+    const double bearing = 2.0 * M_PI * unit(rng);
+    const double cx = dist * std::cos(bearing);
+    const double cy = dist * std::sin(bearing);
+    const double radius = 30.0 + 170.0 * unit(rng);
+    fences[f].id = 100 + f;
+    for (uint32_t v = 0; v < vertices; ++v) {
+      // Increasing angles keep the star polygon simple; radial jitter
+      // gives it a ragged, garden-like outline.
+      const double a = 2.0 * M_PI * (v + 0.8 * unit(rng)) / vertices;
+      const double r = radius * (0.6 + 0.4 * unit(rng));
+      server::GeoPoint p;
+      p.lat_e7 = model.home_lat_e7 +
+                 static_cast<int32_t>((cy + r * std::sin(a)) * lat_per_m);
+      p.lon_e7 = model.home_lon_e7 +
+                 static_cast<int32_t>((cx + r * std::cos(a)) * lon_per_m);
+      fences[f].vertices.push_back(p);
+    }
+  }
+  return fences;
+}
+
+// Every vertex, plus a lattice point inside each edge that has one.
+std::vector<std::pair<uint32_t, server::GeoPoint>> boundary_points(
+    const std::vector<server::Fence>& fences) {
+  std::vector<std::pair<uint32_t, server::GeoPoint>> out;
+  for (uint32_t f = 0; f < fences.size(); ++f) {
+    const std::vector<server::GeoPoint>& v = fences[f].vertices;
+    for (size_t i = 0; i < v.size(); ++i) {
+      const server::GeoPoint& a = v[i];
+      const server::GeoPoint& b = v[(i + 1) % v.size()];
+      out.emplace_back(f, a);
+      const int32_t dlat = b.lat_e7 - a.lat_e7;
+      const int32_t dlon = b.lon_e7 - a.lon_e7;
+      const int32_t g = std::gcd(dlat, dlon);
+      if (g < 2) continue;
+      server::GeoPoint p;
+      p.lat_e7 = a.lat_e7 + dlat / g * (g / 2);
+      p.lon_e7 = a.lon_e7 + dlon / g * (g / 2);
+      out.emplace_back(f, p);
+    }
+  }
+  return out;
+}
+
+// Corners and side midpoints of a 100 x 100 square. A boundary point counts
+// as moved a hair east and north, so only the west and south sides (and the
+// south-west corner) are inside.
+bool square_rule_holds(const sim::TrackModel& model) {
+  const int32_t lat0 = model.home_lat_e7;
+  const int32_t lon0 = model.home_lon_e7;
+  server::Fence square;
+  square.id = 1;
+  square.vertices = {{lat0, lon0}, {lat0, lon0 + 100},
+                     {lat0 + 100, lon0 + 100}, {lat0 + 100, lon0}};
+  server::FenceIndex index;
+  if (!is_ok(server::FenceIndex::build({square}, server::FenceIndexOptions(),
+                                       &index))) {
+    return false;
+  }
+  struct Case {
+    int32_t dlat, dlon;
+    bool inside;
+  };
+  const Case cases[] = {
+      {0, 0, true},     {0, 50, true},    {0, 100, false}, {50, 0, true},
+      {50, 50, true},   {50, 100, false}, {100, 0, false}, {100, 50, false},
+      {100, 100, false}};
+  for (const Case& c : cases) {
+    uint64_t mask = 0;
+    index.locate(lat0 + c.dlat, lon0 + c.dlon, &mask);
+    if ((mask & 1) != c.inside ||
+        index.contains_slow(0, lat0 + c.dlat, lon0 + c.dlon) != c.inside) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool same_events(const std::vector<server::FenceEvent>& a,
+                 const std::vector<server::FenceEvent>& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].device_id != b[i].device_id || a[i].fence_id != b[i].fence_id ||
+        a[i].time_s != b[i].time_s || a[i].entered != b[i].entered) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Events from GeofenceSink behind a 4-worker pipeline against a tracker run
+// directly over the same tracks. Workers interleave devices, so both lists
+// are compared grouped by device, each device's events in order.
+bool sink_matches_tracker(uint32_t devices, uint32_t seed) {
+  server::LoadConfig config;
+  config.devices = devices;
+  config.seed = seed;
+  const server::Load load = server::generate_load(config);
+
+  std::vector<std::shared_ptr<const server::FenceIndex>> indexes(devices + 1);
+  for (uint32_t d = 1; d <= devices; ++d) {
+    auto index = std::make_shared<server::FenceIndex>();
+    if (!is_ok(server::FenceIndex::build(
+            make_fences(8, 64, seed + d, server::device_model(d, config)),
+            server::FenceIndexOptions(), index.get()))) {
+      return false;
+    }
+    indexes[d] = index;
+  }
+  const server::FenceLookup lookup = [&indexes](uint32_t device_id) {
+    return device_id < indexes.size() ? indexes[device_id] : nullptr;
+  };
+
+  const unsigned workers = 4;
+  std::vector<std::vector<server::FenceEvent>> per_worker(workers);
+  server::IngestStats stats;
+  {
+    server::IngestConfig ic;
+    ic.workers = workers;
+    server::IngestPipeline pipeline(ic, [&](unsigned w) {
+      std::vector<server::FenceEvent>* out = &per_worker[w];
+      return std::make_unique<server::GeofenceSink>(
+          lookup, server::GeofencePolicy(),
+          [out](const std::vector<server::FenceEvent>& events) {
+            out->insert(out->end(), events.begin(), events.end());
+          });
+    });
+    for (const auto& buffer : load.buffers) pipeline.submit(buffer);
+    stats = pipeline.finish();
+  }
+  std::vector<server::FenceEvent> piped;
+  for (const auto& events : per_worker) {
+    piped.insert(piped.end(), events.begin(), events.end());
+  }
+  std::stable_sort(
+      piped.begin(), piped.end(),
+      [](const server::FenceEvent& a, const server::FenceEvent& b) {
+        return a.device_id < b.device_id;
+      });
+
+  server::GeofenceTracker tracker(lookup);
+  std::vector<server::FenceEvent> direct;
+  for (uint32_t d = 1; d <= devices; ++d) {
+    for (const track::Fix& fix : server::device_track(d, config)) {
+      tracker.update(d, fix, &direct);
+    }
+  }
+
+  const bool ok = stats.fixes == load.fixes && same_events(piped, direct);
+  std::printf("ingest pipeline -> GeofenceSink: %u devices, %llu fixes, "
+              "%zu events (%zu direct), %s\n",
+              devices, static_cast<unsigned long long>(stats.fixes),
+              piped.size(), direct.size(), ok ? "ok" : "MISMATCH");
+  return ok;
+}
+
+struct Box {
+  int32_t lat0, lon0, lat1, lon1;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sim::Flags flags(argc, argv);
+  const std::vector<uint32_t> fence_counts =
+      parse_list(flags.get("fences", "1,4,16,64"));
+  const std::vector<uint32_t> vertex_counts =
+      parse_list(flags.get("vertices", "8,64,512,4096"));
+  const uint32_t fixes = static_cast<uint32_t>(flags.get_u64("fixes", 200000));
+  const uint32_t sink_devices =
+      static_cast<uint32_t>(flags.get_u64("sink_devices", 200));
+  const uint32_t seed = static_cast<uint32_t>(flags.get_u64("seed", 1));
+
+  sim::TrackModel model;
+  model.interval_s = 10;
+  const std::vector<track::Fix> track = sim::make_cat_track(fixes, seed, model);
+  std::printf("query points: %zu fixes of a synthetic cat track\n",
+              track.size());
+  bool ok = square_rule_holds(model);
+  std::printf("boundary rule on a square: %s\n\n", ok ? "ok" : "MISMATCH");
+
+  std::printf("%6s %8s %8s %9s %9s %12s %12s %9s %7s %s\n", "fences",
+              "vertices", "cells", "index_KiB", "build_ms", "indexed/s",
+              "brute/s", "speedup", "events", "result");
+  for (uint32_t nf : fence_counts) {
+    for (uint32_t nv : vertex_counts) {
+      const std::vector<server::Fence> fences =
+          make_fences(nf, nv, seed * 7919u + nf * 31u + nv, model);
+      auto index = std::make_shared<server::FenceIndex>();
+      const auto tb = std::chrono::steady_clock::now();
+      const Status st =
+          server::FenceIndex::build(fences, server::FenceIndexOptions(),
+                                    index.get());
+      const double build_s = seconds_since(tb);
+      if (!is_ok(st)) {
+        std::printf("build failed: %s\n", status_name(st));
+        return 1;
+      }
+
+      // Indexed: one locate() per fix, all fences at once.
+      const size_t words = index->mask_words();
+      std::vector<uint64_t> masks(track.size() * words);
+      const auto ti = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < track.size(); ++i) {
+        index->locate(track[i].lat_e7, track[i].lon_e7, &masks[i * words]);
+      }
+      const double indexed_s = seconds_since(ti);
+
+      // Brute force over a prefix of the points, checked against the index.
+      std::vector<Box> boxes;
+      for (const server::Fence& f : fences) {
+        Box b{INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN};
+        for (const server::GeoPoint& v : f.vertices) {
+          b.lat0 = std::min(b.lat0, v.lat_e7);
+          b.lon0 = std::min(b.lon0, v.lon_e7);
+          b.lat1 = std::max(b.lat1, v.lat_e7);
+          b.lon1 = std::max(b.lon1, v.lon_e7);
+        }
+        boxes.push_back(b);
+      }
+      const size_t brute_n = std::min<size_t>(
+          track.size(),
+          std::max<size_t>(1000, static_cast<size_t>(
+                                     kBruteEdgeBudget / (double(nf) * nv))));
+      size_t mismatches = 0;
+      const auto tr = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < brute_n; ++i) {
+        const track::Fix& p = track[i];
+        for (uint32_t f = 0; f < nf; ++f) {
+          const Box& b = boxes[f];
+          const bool inside = p.lat_e7 >= b.lat0 && p.lat_e7 <= b.lat1 &&
+                              p.lon_e7 >= b.lon0 && p.lon_e7 <= b.lon1 &&
+                              index->contains_slow(f, p.lat_e7, p.lon_e7);
+          const bool indexed = (masks[i * words + f / 64] >> (f % 64)) & 1;
+          mismatches += inside != indexed;
+        }
+      }
+      const double brute_s = seconds_since(tr);
+
+      // Vertices and edge points, untimed, against their own fence.
+      const auto edge_points = boundary_points(fences);
+      const size_t stride = std::max<size_t>(
+          1, edge_points.size() * nv / static_cast<size_t>(kBruteEdgeBudget));
+      std::vector<uint64_t> mask(words);
+      for (size_t i = 0; i < edge_points.size(); i += stride) {
+        const uint32_t f = edge_points[i].first;
+        const server::GeoPoint& p = edge_points[i].second;
+        index->locate(p.lat_e7, p.lon_e7, mask.data());
+        const bool indexed = (mask[f / 64] >> (f % 64)) & 1;
+        mismatches += indexed != index->contains_slow(f, p.lat_e7, p.lon_e7);
+      }
+
+      // Incremental enter/exit state over the same track.
+      server::GeofenceTracker tracker(
+          [&index](uint32_t) { return index; });
+      std::vector<server::FenceEvent> events;
+      for (const track::Fix& fix : track) tracker.update(1, fix, &events);
+
+      const double indexed_rate = track.size() / indexed_s;
+      const double brute_rate = brute_n / brute_s;
+      ok = ok && mismatches == 0;
+      std::printf("%6u %8u %8zu %9.1f %9.2f %12.0f %12.0f %8.1fx %7zu %s\n",
+                  nf, nv, index->cell_count(),
+                  index->memory_bytes() / 1024.0, build_s * 1e3, indexed_rate,
+                  brute_rate, indexed_rate / brute_rate, events.size(),
+                  mismatches == 0 ? "ok" : "MISMATCH");
+    }
+  }
+  std::printf("\n");
+  ok = sink_matches_tracker(sink_devices, seed) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+// Measures server ingest throughput on synthetic multi-device traffic.
+//
+//   ingest_bench [--devices=N] [--fixes_per_device=N] [--threads=1,2,4,8]
+//                [--duplicates=P] [--seed=N]
+//
+// Each run pushes the same receive buffers through a fresh pipeline and
+// checks frame, fix and duplicate counts plus a checksum over every decoded
+// fix against what the generator produced.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ingest/fix_decoder.h"
+#include "ingest/ingest_pipeline.h"
+#include "loadgen/load_generator.h"
+#include "sim/flags.h"
+
+using namespace ct;
+
+namespace {
+
+class ChecksumSink : public server::IngestSink {
+ public:
+  explicit ChecksumSink(std::atomic<uint64_t>* total) : total_(total) {}
+  ~ChecksumSink() override { total_->fetch_add(sum_); }
+
+  void consume(uint32_t device_id, const server::FixBlock& block) override {
+    for (uint32_t i = 0; i < block.count; ++i) {
+      sum_ += server::fix_checksum(device_id, block.time_s[i],
+                                   block.lat_e7[i], block.lon_e7[i]);
+    }
+  }
+
+ private:
+  std::atomic<uint64_t>* total_;
+  uint64_t sum_ = 0;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+// Parse + decode on the calling thread only, no routing or queues.
+double decode_only(const server::Load& load) {
+  const auto t0 = std::chrono::steady_clock::now();
+  server::FixBlock block;
+  uint64_t fixes = 0;
+  for (const auto& buffer : load.buffers) {
+    server::FrameCursor cursor(buffer->data(), buffer->size());
+    const uint8_t* frame = nullptr;
+    size_t len = 0;
+    while (cursor.next(&frame, &len)) {
+      server::FrameView view;
+      if (is_ok(server::parse_frame(frame, len, &view)) &&
+          is_ok(server::decode_fixes(view, &block))) {
+        fixes += block.count;
+      }
+    }
+  }
+  const double s = seconds_since(t0);
+  return fixes / s;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sim::Flags flags(argc, argv);
+  server::LoadConfig config;
+  config.devices = static_cast<uint32_t>(flags.get_u64("devices", 10000));
+  config.fixes_per_device =
+      static_cast<uint32_t>(flags.get_u64("fixes_per_device", 500));
+  config.duplicate_rate = flags.get_double("duplicates", 0.01);
+  config.seed = static_cast<uint32_t>(flags.get_u64("seed", 1));
+
+  std::vector<unsigned> threads;
+  std::stringstream list(flags.get("threads", "1,2,4,8"));
+  for (std::string item; std::getline(list, item, ',');) {
+    if (!item.empty()) {
+      threads.push_back(static_cast<unsigned>(std::stoul(item)));
+    }
+  }
+
+  const auto tg = std::chrono::steady_clock::now();
+  const server::Load load = server::generate_load(config);
+  std::printf("load: %u devices, %llu frames (+%llu duplicates), %llu fixes, "
+              "%.1f MiB in %zu buffers, generated in %.1f s\n",
+              config.devices, static_cast<unsigned long long>(load.frames),
+              static_cast<unsigned long long>(load.duplicates),
+              static_cast<unsigned long long>(load.fixes),
+              load.bytes / (1024.0 * 1024.0), load.buffers.size(),
+              seconds_since(tg));
+  std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+  std::printf("decode only, 1 thread: %.2f M fixes/s\n\n",
+              decode_only(load) / 1e6);
+
+  std::printf("%8s %12s %12s %10s %8s %s\n", "workers", "frames/s",
+              "fixes/s", "MiB/s", "speedup", "result");
+  bool ok = true;
+  double base_rate = 0.0;
+  for (unsigned n : threads) {
+    std::atomic<uint64_t> checksum{0};
+    server::IngestStats stats;
+    const auto t0 = std::chrono::steady_clock::now();
+    {
+      server::IngestConfig ic;
+      ic.workers = n;
+      server::IngestPipeline pipeline(ic, [&checksum](unsigned) {
+        return std::make_unique<ChecksumSink>(&checksum);
+      });
+      for (const auto& buffer : load.buffers) pipeline.submit(buffer);
+      stats = pipeline.finish();
+    }
+    const double s = seconds_since(t0);
+    const bool match = stats.frames == load.frames &&
+                       stats.fixes == load.fixes &&
+                       stats.duplicates == load.duplicates &&
+                       stats.corrupt == 0 && checksum.load() == load.checksum;
+    ok = ok && match;
+    const double rate = stats.frames / s;
+    if (base_rate == 0.0) base_rate = rate;
+    std::printf("%8u %12.0f %12.0f %10.1f %7.2fx %s\n", n, rate,
+                stats.fixes / s, load.bytes / s / (1024.0 * 1024.0),
+                rate / base_rate, match ? "ok" : "MISMATCH");
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+// Discrete-event simulation of a staged OTA rollout over a whole fleet.
+//
+//   rollout_sim [--devices=10000,100000,1000000] [--gateway_mean=50]
+//               [--stages=0.01,0.05,0.25,1] [--soak_s=1800]
+//               [--image_kib=256] [--rate_kib=2] [--gateway_kib=12]
+//               [--per_gateway=N] [--max_active=N] [--reach_s=30]
+//               [--confirm_s=40] [--fail=0.01] [--bad=0] [--pause_at=0.1]
+//               [--seed=N]
+//
+// Devices hang off gateways whose sizes follow a lognormal around
+// --gateway_mean. A transfer waits for the device to check in (exponential,
+// mean --reach_s), streams the image at the device's link rate (uniform in
+// 0.5x..1.5x --rate_kib), then boots and health-checks it for --confirm_s.
+// Each attempt drops mid-transfer with probability --fail; a --bad share of
+// devices always rejects the new image. Unless given, per_gateway is the
+// most transfers that fit --gateway_kib at the fastest link rate.
+//
+// Each fleet runs twice with the same devices: through RolloutPlanner, and
+// pushed to everyone at once. Rows give rollout time, peak transfers, peak
+// fleet and gateway bandwidth (gw_load is the busiest gateway's peak over
+// --gateway_kib), and how many devices received the image. Links are not
+// slowed by overload, so push-all times are a lower bound. The staged run
+// checks the gateway and fleet caps held and every device was settled
+// unless the rollout paused.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rollout/rollout_planner.h"
+#include "sim/flags.h"
+
+using namespace ct;
+
+namespace {
+
+struct Fleet {
+  std::vector<server::RolloutDevice> devices;
+  std::vector<float> rate_kib;  // link rate per device
+  std::vector<uint8_t> bad;     // rejects the new image
+  uint32_t gateways = 0;
+};
+
+struct Params {
+  double image_kib = 256.0;
+  double gateway_kib = 12.0;
+  double reach_s = 30.0;
+  double confirm_s = 40.0;
+  double fail = 0.01;
+  uint32_t seed = 1;
+};
+
+struct Result {
+  double rollout_s = 0.0;
+  uint32_t peak_transfers = 0;
+  double peak_kib = 0.0;
+  double peak_gateway_kib = 0.0;
+  uint32_t peak_gateway_transfers = 0;
+  uint64_t exposed = 0;
+  uint64_t events = 0;
+  double wall_s = 0.0;
+  server::RolloutStats stats;
+  server::RolloutState state = server::RolloutState::kRunning;
+};
+
+enum class EventKind : uint8_t { kDataStart, kDataEnd, kOutcome, kWakeup };
+
+struct Event {
+  double t;
+  uint32_t handle;
+  EventKind kind;
+
+  bool operator>(const Event& o) const { return t > o.t; }
+};
+
+std::vector<double> parse_list(const std::string& text) {
+  std::vector<double> out;
+  std::stringstream list(text);
+  for (std::string item; std::getline(list, item, ',');) {
+    if (!item.empty()) out.push_back(std::stod(item));
+  }
+  return out;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+Fleet make_fleet(uint32_t count, double gateway_mean, double rate_kib,
+                 double bad, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  // exp(mu + sigma^2 / 2) = gateway_mean with sigma = 1.
+  std::lognormal_distribution<double> size(std::log(gateway_mean) - 0.5, 1.0);
+  Fleet fleet;
+  fleet.devices.resize(count);
+  fleet.rate_kib.resize(count);
+  fleet.bad.resize(count);
+  uint32_t left_on_gateway = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (left_on_gateway == 0) {
+      left_on_gateway =
+          std::max<uint32_t>(1, static_cast<uint32_t>(size(rng) + 0.5));
+      ++fleet.gateways;
+    }
+    --left_on_gateway;
+    fleet.devices[i].device_id = 1000000 + i;
+    fleet.devices[i].gateway_id = fleet.gateways - 1;
+    fleet.rate_kib[i] = static_cast<float>(rate_kib * (0.5 + unit(rng)));
+    fleet.bad[i] = unit(rng) < bad ? 1 : 0;
+  }
+  return fleet;
+}
+
+Result simulate(const Fleet& fleet, const server::RolloutPolicy& policy,
+                const Params& params) {
+  const auto t0 = std::chrono::steady_clock::now();
+  server::RolloutPlanner planner(fleet.devices, policy);
+  std::mt19937 rng(params.seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::exponential_distribution<double> reach(1.0 / params.reach_s);
+
+  const size_t count = fleet.devices.size();
+  std::vector<uint8_t> outcome_ok(count, 0);
+  std::vector<uint8_t> tried(count, 0);
+  std::vector<uint32_t> gw_transfers(fleet.gateways, 0);
+  std::vector<double> gw_kib(fleet.gateways, 0.0);
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  std::vector<server::RolloutTransfer> started;
+  Result result;
+  double fleet_kib = 0.0;
+  double wakeup_s = INFINITY;
+
+  auto poll = [&](double now) {
+    started.clear();
+    planner.poll(now, &started);
+    for (const server::RolloutTransfer& tr : started) {
+      const uint32_t h = tr.handle;
+      tried[h] = 1;
+      result.peak_gateway_transfers = std::max(
+          result.peak_gateway_transfers, ++gw_transfers[tr.gateway_id]);
+      const double begin = now + reach(rng);
+      const double data_s = params.image_kib / fleet.rate_kib[h];
+      events.push({begin, h, EventKind::kDataStart});
+      if (unit(rng) < params.fail) {
+        const double end = begin + data_s * unit(rng);
+        outcome_ok[h] = 0;
+        events.push({end, h, EventKind::kDataEnd});
+        events.push({end, h, EventKind::kOutcome});
+      } else {
+        outcome_ok[h] = fleet.bad[h] ? 0 : 1;
+        events.push({begin + data_s, h, EventKind::kDataEnd});
+        events.push({begin + data_s + params.confirm_s, h,
+                     EventKind::kOutcome});
+      }
+    }
+    const double next = planner.next_wakeup_s();
+    if (next != wakeup_s && std::isfinite(next)) {
+      wakeup_s = next;
+      events.push({next, 0, EventKind::kWakeup});
+    }
+  };
+
+  poll(0.0);
+  double now = 0.0;
+  while (!events.empty()) {
+    const Event ev = events.top();
+    events.pop();
+    now = ev.t;
+    ++result.events;
+    const uint32_t g = fleet.devices[ev.handle].gateway_id;
+    switch (ev.kind) {
+      case EventKind::kDataStart:
+        fleet_kib += fleet.rate_kib[ev.handle];
+        gw_kib[g] += fleet.rate_kib[ev.handle];
+        result.peak_kib = std::max(result.peak_kib, fleet_kib);
+        result.peak_gateway_kib = std::max(result.peak_gateway_kib, gw_kib[g]);
+        break;
+      case EventKind::kDataEnd:
+        fleet_kib -= fleet.rate_kib[ev.handle];
+        gw_kib[g] -= fleet.rate_kib[ev.handle];
+        break;
+      case EventKind::kOutcome:
+        --gw_transfers[g];
+        planner.report(ev.handle, outcome_ok[ev.handle] != 0);
+        poll(now);
+        break;
+      case EventKind::kWakeup:
+        if (now >= wakeup_s) poll(now);
+        break;
+    }
+  }
+  result.rollout_s = now;
+  result.peak_transfers = planner.stats().peak_active;
+  for (uint8_t t : tried) result.exposed += t;
+  result.stats = planner.stats();
+  result.state = planner.state();
+  result.wall_s = seconds_since(t0);
+  return result;
+}
+
+const char* state_name(server::RolloutState state) {
+  switch (state) {
+    case server::RolloutState::kRunning:
+      return "running";
+    case server::RolloutState::kSoaking:
+      return "soaking";
+    case server::RolloutState::kPaused:
+      return "paused";
+    case server::RolloutState::kDone:
+      return "done";
+  }
+  return "?";
+}
+
+void print_row(const char* plan, size_t devices, uint32_t gateways,
+               const Result& r, const Params& params, const char* verdict) {
+  std::printf("%-8s %8zu %8u %8.2f %8u %9.2f %9.1f %7.2f %8llu %9llu %7llu "
+              "%6llu %-7s %9.0f %s\n",
+              plan, devices, gateways, r.rollout_s / 3600.0, r.peak_transfers,
+              r.peak_kib / 1024.0, r.peak_gateway_kib,
+              r.peak_gateway_kib / params.gateway_kib,
+              static_cast<unsigned long long>(r.exposed),
+              static_cast<unsigned long long>(r.stats.confirmed),
+              static_cast<unsigned long long>(r.stats.failed),
+              static_cast<unsigned long long>(r.stats.pauses),
+              state_name(r.state), r.events / r.wall_s, verdict);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sim::Flags flags(argc, argv);
+  const std::vector<double> sizes =
+      parse_list(flags.get("devices", "10000,100000,1000000"));
+  const double gateway_mean = flags.get_double("gateway_mean", 50.0);
+  const double rate_kib = flags.get_double("rate_kib", 2.0);
+  const double bad = flags.get_double("bad", 0.0);
+
+  Params params;
+  params.image_kib = flags.get_double("image_kib", 256.0);
+  params.gateway_kib = flags.get_double("gateway_kib", 12.0);
+  params.reach_s = flags.get_double("reach_s", 30.0);
+  params.confirm_s = flags.get_double("confirm_s", 40.0);
+  params.fail = flags.get_double("fail", 0.01);
+  params.seed = static_cast<uint32_t>(flags.get_u64("seed", 1));
+
+  server::RolloutPolicy staged;
+  staged.stages = parse_list(flags.get("stages", "0.01,0.05,0.25,1"));
+  staged.soak_s = flags.get_double("soak_s", 1800.0);
+  staged.per_gateway = static_cast<uint32_t>(flags.get_u64(
+      "per_gateway",
+      std::max(1.0, std::floor(params.gateway_kib / (1.5 * rate_kib)))));
+  staged.max_active = static_cast<uint32_t>(flags.get_u64("max_active", 0));
+  staged.pause_failure_rate = flags.get_double("pause_at", 0.1);
+
+  server::RolloutPolicy push_all;
+  push_all.stages = {1.0};
+  push_all.per_gateway = UINT32_MAX;
+  push_all.soak_s = 0.0;
+  push_all.pause_failure_rate = 1.0;
+
+  std::printf("image %.0f KiB, link %.1f KiB/s mean, gateway budget %.1f KiB/s "
+              "(%u transfers), %zu stages, soak %.0f s\n\n",
+              params.image_kib, rate_kib, params.gateway_kib,
+              staged.per_gateway, staged.stages.size(), staged.soak_s);
+  std::printf("%-8s %8s %8s %8s %8s %9s %9s %7s %8s %9s %7s %6s %-7s %9s %s\n",
+              "plan", "devices", "gateways", "hours", "xfers", "MiB/s",
+              "gw_KiB/s", "gw_load", "exposed", "confirmed", "failed",
+              "pauses", "state", "events/s", "result");
+
+  bool ok = true;
+  for (double size : sizes) {
+    const Fleet fleet = make_fleet(static_cast<uint32_t>(size), gateway_mean,
+                                   rate_kib, bad, params.seed);
+    const size_t n = fleet.devices.size();
+
+    const Result s = simulate(fleet, staged, params);
+    const bool settled = s.stats.confirmed + s.stats.failed == n;
+    bool good = s.peak_gateway_transfers <= staged.per_gateway &&
+                (staged.max_active == 0 ||
+                 s.peak_transfers <= staged.max_active) &&
+                s.stats.active == 0 &&
+                (s.state == server::RolloutState::kDone
+                     ? settled
+                     : s.state == server::RolloutState::kPaused);
+    ok = ok && good;
+    print_row("staged", n, fleet.gateways, s, params,
+              good ? "ok" : "CAP_OR_STATE_MISMATCH");
+
+    const Result p = simulate(fleet, push_all, params);
+    print_row("push-all", n, fleet.gateways, p, params, "-");
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+// Measures streaming track simplification on a large synthetic history.
+//
+//   simplify_bench [--points=N] [--zooms=18,16,14,12,10] [--interval=S]
+//                  [--seed=N]
+//
+// Each zoom level's tolerance is one screen pixel. For every level the
+// streaming simplifier's throughput and compression ratio are printed next
+// to a classic in-memory Douglas-Peucker at the same tolerance, and every
+// input fix is checked to lie within tolerance of the simplified polyline.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "history/track_simplifier.h"
+#include "sim/flags.h"
+#include "sim/synthetic_track.h"
+#include "track/geo.h"
+
+using namespace ct;
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+// Distance from p to segment ab, projected at a like the simplifier does.
+double segment_distance_m(const track::Fix& p, const track::Fix& a,
+                          const track::Fix& b) {
+  const double sx = track::lon_scale_m(a.lat_e7);
+  const double sy = track::kMetersPerDegree * 1e-7;
+  const double bx = (int64_t{b.lon_e7} - a.lon_e7) * sx;
+  const double by = (int64_t{b.lat_e7} - a.lat_e7) * sy;
+  const double px = (int64_t{p.lon_e7} - a.lon_e7) * sx;
+  const double py = (int64_t{p.lat_e7} - a.lat_e7) * sy;
+  const double len2 = bx * bx + by * by;
+  double t = len2 > 0.0 ? (px * bx + py * by) / len2 : 0.0;
+  t = std::min(1.0, std::max(0.0, t));
+  return std::hypot(px - t * bx, py - t * by);
+}
+
+// Largest distance from an input fix to the simplified polyline. Output
+// fixes are a subsequence of the input, matched by timestamp.
+double max_error_m(const std::vector<track::Fix>& in,
+                   const std::vector<track::Fix>& out) {
+  if (out.empty() || out.front() != in.front() || out.back() != in.back()) {
+    return INFINITY;
+  }
+  double worst = 0.0;
+  size_t j = 0;
+  for (const track::Fix& p : in) {
+    if (j + 1 < out.size() && p.time_s == out[j + 1].time_s) {
+      if (p != out[j + 1]) return INFINITY;
+      ++j;
+      continue;
+    }
+    if (j + 1 < out.size()) {
+      worst = std::max(worst, segment_distance_m(p, out[j], out[j + 1]));
+    }
+  }
+  return j + 1 == out.size() ? worst : INFINITY;
+}
+
+// Reference: recursive-split Douglas-Peucker with an explicit stack. Needs
+// the whole track in memory.
+size_t douglas_peucker(const std::vector<track::Fix>& in, double tolerance_m) {
+  if (in.size() < 3) return in.size();
+  std::vector<uint8_t> keep(in.size(), 0);
+  keep.front() = keep.back() = 1;
+  std::vector<std::pair<size_t, size_t>> stack{{0, in.size() - 1}};
+  while (!stack.empty()) {
+    const auto [first, last] = stack.back();
+    stack.pop_back();
+    double worst = 0.0;
+    size_t split = first;
+    for (size_t i = first + 1; i < last; ++i) {
+      const double d = segment_distance_m(in[i], in[first], in[last]);
+      if (d > worst) {
+        worst = d;
+        split = i;
+      }
+    }
+    if (worst > tolerance_m) {
+      keep[split] = 1;
+      stack.emplace_back(first, split);
+      stack.emplace_back(split, last);
+    }
+  }
+  return static_cast<size_t>(std::count(keep.begin(), keep.end(), 1));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sim::Flags flags(argc, argv);
+  const uint32_t points =
+      static_cast<uint32_t>(flags.get_u64("points", 2000000));
+  const uint32_t seed = static_cast<uint32_t>(flags.get_u64("seed", 1));
+  std::vector<int> zooms;
+  std::stringstream list(flags.get("zooms", "18,16,14,12,10"));
+  for (std::string item; std::getline(list, item, ',');) {
+    if (!item.empty()) zooms.push_back(std::stoi(item));
+  }
+
+  sim::TrackModel model;
+  model.interval_s = static_cast<uint32_t>(flags.get_u64("interval", 10));
+  const std::vector<track::Fix> track =
+      sim::make_cat_track(points, seed, model);
+  std::printf("track: %zu fixes, %u s interval, %.1f days\n\n", track.size(),
+              model.interval_s,
+              (track.back().time_s - track.front().time_s) / 86400.0);
+
+  std::vector<double> tolerances;
+  for (int z : zooms) {
+    tolerances.push_back(server::zoom_tolerance_m(z, model.home_lat_e7));
+  }
+
+  std::printf("%5s %8s %10s %8s %9s %12s %10s %8s %12s %s\n", "zoom", "tol_m",
+              "kept", "ratio", "max_err", "points/s", "dp_kept", "dp_ratio",
+              "dp_points/s", "result");
+  bool ok = true;
+  for (size_t level = 0; level < zooms.size(); ++level) {
+    const double tol = tolerances[level];
+    std::vector<track::Fix> out;
+    out.reserve(track.size() / 4);
+    const auto t0 = std::chrono::steady_clock::now();
+    server::TrackSimplifier simplifier(tol);
+    track::Fix v;
+    for (const track::Fix& fix : track) {
+      if (simplifier.add(fix, &v)) out.push_back(v);
+    }
+    if (simplifier.finish(&v)) out.push_back(v);
+    const double stream_s = seconds_since(t0);
+
+    const auto td = std::chrono::steady_clock::now();
+    const size_t dp_kept = douglas_peucker(track, tol);
+    const double dp_s = seconds_since(td);
+
+    const double err = max_error_m(track, out);
+    const bool good = err <= tol * (1.0 + 1e-9);
+    ok = ok && good;
+    std::printf("%5d %8.2f %10zu %7.1fx %9.2f %12.0f %10zu %7.1fx %12.0f %s\n",
+                zooms[level], tol, out.size(),
+                double(track.size()) / out.size(), err,
+                track.size() / stream_s, dp_kept,
+                double(track.size()) / dp_kept, track.size() / dp_s,
+                good ? "ok" : "OVER_TOLERANCE");
+  }
+
+  // All levels from one read of the history.
+  std::vector<size_t> kept(zooms.size(), 0);
+  const auto ta = std::chrono::steady_clock::now();
+  server::ZoomSimplifier pyramid(
+      tolerances, [&kept](size_t level, const track::Fix&) { ++kept[level]; });
+  for (const track::Fix& fix : track) pyramid.add(fix);
+  pyramid.finish();
+  const double all_s = seconds_since(ta);
+  size_t total = 0;
+  for (size_t k : kept) total += k;
+  std::printf("\nall %zu levels in one pass: %.0f points/s, %zu vertices "
+              "(%.1f%% of input)\n",
+              zooms.size(), track.size() / all_s, total,
+              100.0 * total / track.size());
+  return ok ? 0 : 1;
+}